@@ -0,0 +1,231 @@
+#include "AreaClamping.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define AREA_CLAMPING_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// the lanes are compiled for their instruction set regardless of the flags
+// the file is built with, the set is chosen at run time. MSVC accepts the
+// intrinsics without it
+#if defined(_MSC_VER) && !defined(__clang__)
+#define AREA_CLAMPING_TARGET(isa)
+#else
+#define AREA_CLAMPING_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace graphics {
+
+namespace {
+
+// areas are clamped in chunks, a chunk is packed into 32-bit lanes and fills
+// a few AVX2 registers
+constexpr SizeType kChunkSize{32};
+
+struct PackedAreas {
+  alignas(32) std::uint32_t pos_x[kChunkSize];
+  alignas(32) std::uint32_t pos_y[kChunkSize];
+  alignas(32) std::uint32_t width[kChunkSize];
+  alignas(32) std::uint32_t height[kChunkSize];
+};
+
+// size = min(size, parent_size)
+// pos = min(max(pos, parent_pos), parent_pos + parent_size - size)
+using ClampLanesFunction = void (*)(std::uint32_t *pos, std::uint32_t *size,
+                                    std::uint32_t parent_pos,
+                                    std::uint32_t parent_size,
+                                    SizeType count) noexcept;
+
+// values above the 32-bit range are saturated, the result is clamped to the
+// parent anyway
+[[nodiscard]] std::uint32_t Pack(SizeType value) noexcept {
+  constexpr SizeType max_value{std::numeric_limits<std::uint32_t>::max()};
+  return static_cast<std::uint32_t>(std::min(value, max_value));
+}
+
+// clamps the lanes the vector loops leave, starting at i
+void ClampTail(std::uint32_t *pos, std::uint32_t *size,
+               std::uint32_t parent_pos, std::uint32_t parent_size,
+               SizeType i, SizeType count) noexcept {
+  for (; i < count; ++i) {
+    size[i] = std::min(size[i], parent_size);
+    pos[i] = std::clamp(pos[i], parent_pos, parent_pos + parent_size - size[i]);
+  }
+}
+
+#if defined(AREA_CLAMPING_X86)
+
+AREA_CLAMPING_TARGET("avx2")
+void ClampLanesAvx2(std::uint32_t *pos, std::uint32_t *size,
+                    std::uint32_t parent_pos, std::uint32_t parent_size,
+                    SizeType count) noexcept {
+  constexpr SizeType lane_count{8};
+
+  auto parent_pos_lanes{_mm256_set1_epi32(static_cast<int>(parent_pos))};
+  auto parent_size_lanes{_mm256_set1_epi32(static_cast<int>(parent_size))};
+  auto parent_end_lanes{_mm256_add_epi32(parent_pos_lanes, parent_size_lanes)};
+
+  SizeType i{};
+  for (; i + lane_count <= count; i += lane_count) {
+    auto pos_ptr{reinterpret_cast<__m256i *>(pos + i)};
+    auto size_ptr{reinterpret_cast<__m256i *>(size + i)};
+
+    auto size_lanes{_mm256_min_epu32(_mm256_load_si256(size_ptr),
+                                     parent_size_lanes)};
+    auto max_pos_lanes{_mm256_sub_epi32(parent_end_lanes, size_lanes)};
+    auto pos_lanes{_mm256_max_epu32(_mm256_load_si256(pos_ptr),
+                                    parent_pos_lanes)};
+    pos_lanes = _mm256_min_epu32(pos_lanes, max_pos_lanes);
+
+    _mm256_store_si256(size_ptr, size_lanes);
+    _mm256_store_si256(pos_ptr, pos_lanes);
+  }
+
+  ClampTail(pos, size, parent_pos, parent_size, i, count);
+}
+
+AREA_CLAMPING_TARGET("sse4.1")
+void ClampLanesSse41(std::uint32_t *pos, std::uint32_t *size,
+                     std::uint32_t parent_pos, std::uint32_t parent_size,
+                     SizeType count) noexcept {
+  constexpr SizeType lane_count{4};
+
+  auto parent_pos_lanes{_mm_set1_epi32(static_cast<int>(parent_pos))};
+  auto parent_size_lanes{_mm_set1_epi32(static_cast<int>(parent_size))};
+  auto parent_end_lanes{_mm_add_epi32(parent_pos_lanes, parent_size_lanes)};
+
+  SizeType i{};
+  for (; i + lane_count <= count; i += lane_count) {
+    auto pos_ptr{reinterpret_cast<__m128i *>(pos + i)};
+    auto size_ptr{reinterpret_cast<__m128i *>(size + i)};
+
+    auto size_lanes{_mm_min_epu32(_mm_load_si128(size_ptr), parent_size_lanes)};
+    auto max_pos_lanes{_mm_sub_epi32(parent_end_lanes, size_lanes)};
+    auto pos_lanes{_mm_max_epu32(_mm_load_si128(pos_ptr), parent_pos_lanes)};
+    pos_lanes = _mm_min_epu32(pos_lanes, max_pos_lanes);
+
+    _mm_store_si128(size_ptr, size_lanes);
+    _mm_store_si128(pos_ptr, pos_lanes);
+  }
+
+  ClampTail(pos, size, parent_pos, parent_size, i, count);
+}
+
+#if defined(_MSC_VER)
+
+[[nodiscard]] bool IsAvx2Supported() noexcept {
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+
+  // the OS has to save the AVX registers too
+  __cpuid(info, 1);
+  constexpr int osxsave_bit{1 << 27};
+  constexpr int avx_bit{1 << 28};
+  if ((info[2] & osxsave_bit) == 0 || (info[2] & avx_bit) == 0 ||
+      (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+
+  __cpuidex(info, 7, 0);
+  constexpr int avx2_bit{1 << 5};
+  return (info[1] & avx2_bit) != 0;
+}
+
+[[nodiscard]] bool IsSse41Supported() noexcept {
+  int info[4];
+  __cpuid(info, 1);
+  constexpr int sse41_bit{1 << 19};
+  return (info[2] & sse41_bit) != 0;
+}
+
+#else
+
+[[nodiscard]] bool IsAvx2Supported() noexcept {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+}
+
+[[nodiscard]] bool IsSse41Supported() noexcept {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("sse4.1");
+}
+
+#endif
+
+#endif  // AREA_CLAMPING_X86
+
+// returns nullptr if the CPU supports none of the instruction sets
+[[nodiscard]] ClampLanesFunction SelectClampLanes() noexcept {
+#if defined(AREA_CLAMPING_X86)
+  if (IsAvx2Supported()) {
+    return ClampLanesAvx2;
+  }
+  if (IsSse41Supported()) {
+    return ClampLanesSse41;
+  }
+#endif
+  return nullptr;
+}
+
+void ClampAreasToParentScalar(const Area &parent, Area *areas,
+                              SizeType count) noexcept {
+  for (SizeType i{}; i < count; ++i) {
+    auto &area{areas[i]};
+    area.width = std::min(area.width, parent.width);
+    area.height = std::min(area.height, parent.height);
+    area.pos_x = std::clamp(area.pos_x, parent.pos_x,
+                            parent.pos_x + parent.width - area.width);
+    area.pos_y = std::clamp(area.pos_y, parent.pos_y,
+                            parent.pos_y + parent.height - area.height);
+  }
+}
+
+}  // namespace
+
+void ClampAreasToParent(const Area &parent, Vector<Area> &areas) noexcept {
+  static const auto clamp_lanes{SelectClampLanes()};
+
+  // the parent has to fit into the lanes, which is true for any window
+  constexpr SizeType max_value{std::numeric_limits<std::uint32_t>::max()};
+  if (!clamp_lanes || parent.pos_x + parent.width > max_value ||
+      parent.pos_y + parent.height > max_value) {
+    ClampAreasToParentScalar(parent, areas.data(), areas.size());
+    return;
+  }
+
+  PackedAreas packed;
+  for (SizeType begin{}; begin < areas.size(); begin += kChunkSize) {
+    auto count{std::min(kChunkSize, areas.size() - begin)};
+    auto chunk{areas.data() + begin};
+
+    for (SizeType i{}; i < count; ++i) {
+      packed.pos_x[i] = Pack(chunk[i].pos_x);
+      packed.pos_y[i] = Pack(chunk[i].pos_y);
+      packed.width[i] = Pack(chunk[i].width);
+      packed.height[i] = Pack(chunk[i].height);
+    }
+
+    clamp_lanes(packed.pos_x, packed.width, Pack(parent.pos_x),
+                Pack(parent.width), count);
+    clamp_lanes(packed.pos_y, packed.height, Pack(parent.pos_y),
+                Pack(parent.height), count);
+
+    for (SizeType i{}; i < count; ++i) {
+      chunk[i] = {packed.pos_x[i], packed.pos_y[i], packed.width[i],
+                  packed.height[i]};
+    }
+  }
+}
+
+}  // namespace graphics
@@ -0,0 +1,17 @@
+#ifndef AREACLAMPING_HPP
+#define AREACLAMPING_HPP
+
+#include "TreeBlockAreas.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+// clamps the areas to the parent the way TreeBlock setters do: a size is
+// limited by the parent's size and a position keeps the area within the
+// parent. The areas are processed in packed 32-bit lanes with AVX2 or SSE4.1
+// when the CPU supports them, no compiler flags are needed
+void ClampAreasToParent(const Area &parent, Vector<Area> &areas) noexcept;
+
+}  // namespace graphics
+
+#endif  // AREACLAMPING_HPP
@@ -0,0 +1,25 @@
+#ifndef BLOCKRENDERSTATE_HPP
+#define BLOCKRENDERSTATE_HPP
+
+#include "GLStateCache.hpp"
+#include "RenderTreeInfo.hpp"
+#include "StreamingBuffer.hpp"
+#include "TreeBlockAreas.hpp"
+
+namespace graphics {
+
+// Structure BlockRenderState is what a handler renders from. The state of the
+// block is captured by RenderTree::BuildFrame, so it stays the same while the
+// event thread keeps changing the tree, and the cache and the buffer belong
+// to the thread rendering the frame.
+struct BlockRenderState {
+  Area area;
+  bool is_hovered;
+  const MouseInfo *mouse_info;  // at the moment the frame was built
+  GLStateCache *gl_state;
+  StreamingBuffer *stream_buffer;
+};
+
+}  // namespace graphics
+
+#endif  // BLOCKRENDERSTATE_HPP
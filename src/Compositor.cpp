@@ -0,0 +1,320 @@
+#include "Compositor.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace graphics {
+
+namespace {
+
+constexpr const char *kVertexShaderCode{R"(
+#version 450 core
+
+layout(location = 0) in vec4 dst_rect;
+layout(location = 1) in vec4 src_rect;
+
+uniform vec2 target_size;
+uniform vec2 atlas_size;
+
+out vec2 tex_coords;
+
+void main() {
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+  vec2 pos = (dst_rect.xy + corner * dst_rect.zw) / target_size;
+  tex_coords = (src_rect.xy + corner * src_rect.zw) / atlas_size;
+  gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)"};
+
+constexpr const char *kFragmentShaderCode{R"(
+#version 450 core
+
+in vec2 tex_coords;
+
+uniform sampler2D atlas;
+
+out vec4 frag_color;
+
+void main() { frag_color = texture(atlas, tex_coords); }
+)"};
+
+constexpr SizeType kInstanceAlignment{16};
+
+}  // namespace
+
+Compositor::Compositor(SizeType max_width, SizeType max_height,
+                       GLStateCache &gl_state,
+                       StreamingBuffer &stream_buffer) noexcept
+    : atlas_width_{max_width},
+      atlas_height_{max_height},
+      gl_state_{gl_state},
+      stream_buffer_{stream_buffer},
+      render_fbo_{},
+      color_rbo_{},
+      depth_stencil_rbo_{},
+      atlas_fbo_{},
+      atlas_texture_{},
+      vao_{},
+      sp_{},
+      target_size_location_{},
+      atlas_size_location_{},
+      shelf_pos_x_{},
+      shelf_pos_y_{},
+      shelf_height_{},
+      used_width_{},
+      target_fbo_{},
+      target_area_{},
+      damage_area_{},
+      profiler_{},
+      instances_{},
+      layer_copies_{} {
+  if (!sp_.CompileAndLinkShaderSources(kVertexShaderCode,
+                                       kFragmentShaderCode)) {
+    exit(1);
+  }
+  target_size_location_ = glGetUniformLocation(sp_.shader_program,
+                                               "target_size");
+  atlas_size_location_ = glGetUniformLocation(sp_.shader_program,
+                                              "atlas_size");
+  glProgramUniform2f(sp_.shader_program, atlas_size_location_,
+                     static_cast<GLfloat>(atlas_width_),
+                     static_cast<GLfloat>(atlas_height_));
+
+  CreateBuffers();
+}
+
+Compositor::~Compositor() {
+  glDeleteFramebuffers(1, &render_fbo_);
+  glDeleteRenderbuffers(1, &color_rbo_);
+  glDeleteRenderbuffers(1, &depth_stencil_rbo_);
+  glDeleteFramebuffers(1, &atlas_fbo_);
+  glDeleteTextures(1, &atlas_texture_);
+  glDeleteVertexArrays(1, &vao_);
+}
+
+void Compositor::BeginFrame(GLuint target_fbo, const Area &target_area,
+                            const Area &damage_area,
+                            RenderProfiler *profiler) noexcept {
+  target_fbo_ = target_fbo;
+  target_area_ = target_area;
+  damage_area_ = damage_area;
+  profiler_ = profiler;
+
+  glProgramUniform2f(sp_.shader_program, target_size_location_,
+                     static_cast<GLfloat>(target_area_.width),
+                     static_cast<GLfloat>(target_area_.height));
+}
+
+void Compositor::EndFrame() noexcept {
+  Flush();
+  gl_state_.Disable(GL_SCISSOR_TEST);
+}
+
+[[nodiscard]] Area Compositor::AllocateBlock(const Area &area) noexcept {
+  Area atlas_area;
+  if (!TryAllocate(area.width, area.height, atlas_area)) {
+    Flush();
+    static_cast<void>(TryAllocate(area.width, area.height, atlas_area));
+  }
+
+  // glClear ignores the viewport, so the scissor keeps the neighbours intact
+  gl_state_.BindFramebuffer(GL_FRAMEBUFFER, render_fbo_);
+  gl_state_.Enable(GL_SCISSOR_TEST);
+  gl_state_.Scissor(atlas_area.pos_x, atlas_area.pos_y, atlas_area.width,
+                    atlas_area.height);
+
+  return atlas_area;
+}
+
+void Compositor::CompositeBlock(const Area &area, const Area &atlas_area,
+                                TreeBlockLayer *layer) noexcept {
+  instances_.push_back(
+      {{static_cast<GLfloat>(area.pos_x - target_area_.pos_x),
+        static_cast<GLfloat>(area.pos_y - target_area_.pos_y),
+        static_cast<GLfloat>(area.width), static_cast<GLfloat>(area.height)},
+       {static_cast<GLfloat>(atlas_area.pos_x),
+        static_cast<GLfloat>(atlas_area.pos_y),
+        static_cast<GLfloat>(atlas_area.width),
+        static_cast<GLfloat>(atlas_area.height)}});
+
+  if (layer && layer->IsAllocated()) {
+    layer_copies_.push_back({layer->GetTexture(), atlas_area, true});
+  }
+}
+
+void Compositor::CompositeLayer(const TreeBlockLayer &layer,
+                                const Area &area) noexcept {
+  Area atlas_area;
+  if (!TryAllocate(area.width, area.height, atlas_area)) {
+    Flush();
+    static_cast<void>(TryAllocate(area.width, area.height, atlas_area));
+  }
+
+  layer_copies_.push_back({layer.GetTexture(), atlas_area, false});
+  CompositeBlock(area, atlas_area, nullptr);
+}
+
+void Compositor::CreateBuffers() noexcept {
+  // the atlas matches the sample count of the default framebuffer, so blocks
+  // keep the same antialiasing they would get on the screen
+  GLint samples{};
+  gl_state_.BindFramebuffer(GL_FRAMEBUFFER, 0);
+  glGetIntegerv(GL_SAMPLES, &samples);
+
+  glCreateRenderbuffers(1, &color_rbo_);
+  glNamedRenderbufferStorageMultisample(color_rbo_, samples, GL_RGBA8,
+                                        atlas_width_, atlas_height_);
+  glCreateRenderbuffers(1, &depth_stencil_rbo_);
+  glNamedRenderbufferStorageMultisample(depth_stencil_rbo_, samples,
+                                        GL_DEPTH24_STENCIL8, atlas_width_,
+                                        atlas_height_);
+
+  glCreateFramebuffers(1, &render_fbo_);
+  glNamedFramebufferRenderbuffer(render_fbo_, GL_COLOR_ATTACHMENT0,
+                                 GL_RENDERBUFFER, color_rbo_);
+  glNamedFramebufferRenderbuffer(render_fbo_, GL_DEPTH_STENCIL_ATTACHMENT,
+                                 GL_RENDERBUFFER, depth_stencil_rbo_);
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &atlas_texture_);
+  glTextureStorage2D(atlas_texture_, 1, GL_RGBA8, atlas_width_,
+                     atlas_height_);
+  glTextureParameteri(atlas_texture_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTextureParameteri(atlas_texture_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  glCreateFramebuffers(1, &atlas_fbo_);
+  glNamedFramebufferTexture(atlas_fbo_, GL_COLOR_ATTACHMENT0, atlas_texture_,
+                            0);
+
+  // checks that created fbos are complete
+  if (glCheckNamedFramebufferStatus(render_fbo_, GL_FRAMEBUFFER) !=
+          GL_FRAMEBUFFER_COMPLETE ||
+      glCheckNamedFramebufferStatus(atlas_fbo_, GL_FRAMEBUFFER) !=
+          GL_FRAMEBUFFER_COMPLETE) {
+    exit(1);
+  }
+
+  // one instance per block, the quad corners are generated in the shader,
+  // the instance buffer is attached in every pass
+  glCreateVertexArrays(1, &vao_);
+  glVertexArrayBindingDivisor(vao_, 0, 1);
+
+  glEnableVertexArrayAttrib(vao_, 0);
+  glVertexArrayAttribFormat(vao_, 0, 4, GL_FLOAT, GL_FALSE,
+                            offsetof(Instance, dst_rect));
+  glVertexArrayAttribBinding(vao_, 0, 0);
+
+  glEnableVertexArrayAttrib(vao_, 1);
+  glVertexArrayAttribFormat(vao_, 1, 4, GL_FLOAT, GL_FALSE,
+                            offsetof(Instance, src_rect));
+  glVertexArrayAttribBinding(vao_, 1, 0);
+}
+
+void Compositor::Flush() noexcept {
+  if (!instances_.empty()) {
+    if (profiler_) {
+      profiler_->BeginComposite();
+    }
+
+    gl_state_.Disable(GL_SCISSOR_TEST);
+
+    // resolve everything rendered in this pass
+    auto used_height{shelf_pos_y_ + shelf_height_};
+    glBlitNamedFramebuffer(render_fbo_, atlas_fbo_, 0, 0, used_width_,
+                           used_height, 0, 0, used_width_, used_height,
+                           GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+    for (const auto &copy : layer_copies_) {
+      const auto &atlas_area{copy.atlas_area};
+      if (copy.is_to_layer) {
+        glCopyImageSubData(atlas_texture_, GL_TEXTURE_2D, 0, atlas_area.pos_x,
+                           atlas_area.pos_y, 0, copy.layer_texture,
+                           GL_TEXTURE_2D, 0, 0, 0, 0, atlas_area.width,
+                           atlas_area.height, 1);
+      } else {
+        glCopyImageSubData(copy.layer_texture, GL_TEXTURE_2D, 0, 0, 0, 0,
+                           atlas_texture_, GL_TEXTURE_2D, 0, atlas_area.pos_x,
+                           atlas_area.pos_y, 0, atlas_area.width,
+                           atlas_area.height, 1);
+      }
+    }
+
+    // blending blocks over the content of the target in tree order
+    gl_state_.BindFramebuffer(GL_FRAMEBUFFER, target_fbo_);
+    gl_state_.Viewport(target_area_.pos_x, target_area_.pos_y,
+                       target_area_.width, target_area_.height);
+    gl_state_.Enable(GL_SCISSOR_TEST);
+    gl_state_.Scissor(damage_area_.pos_x, damage_area_.pos_y,
+                      damage_area_.width, damage_area_.height);
+
+    gl_state_.UseProgram(sp_.shader_program);
+    gl_state_.Enable(GL_BLEND);
+    gl_state_.BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO,
+                                GL_ONE);
+    gl_state_.BlendEquation(GL_FUNC_ADD);
+    gl_state_.BindTextureUnit(0, atlas_texture_);
+    gl_state_.BindVertexArray(vao_);
+
+    // instances are written straight into the mapped ring, a pass that does
+    // not fit into one segment is drawn in several chunks
+    auto max_chunk_size{stream_buffer_.GetSegmentSize() / sizeof(Instance)};
+    SizeType first_instance{};
+    while (first_instance < instances_.size()) {
+      auto chunk_size{
+          std::min(max_chunk_size, instances_.size() - first_instance)};
+      auto chunk_bytes{chunk_size * sizeof(Instance)};
+
+      StreamingBuffer::Allocation allocation;
+      if (!stream_buffer_.Allocate(chunk_bytes, kInstanceAlignment,
+                                   allocation)) {
+        break;
+      }
+      std::memcpy(allocation.data, instances_.data() + first_instance,
+                  chunk_bytes);
+
+      glVertexArrayVertexBuffer(vao_, 0, stream_buffer_.GetBuffer(),
+                                allocation.offset, sizeof(Instance));
+      glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
+                            static_cast<GLsizei>(chunk_size));
+
+      first_instance += chunk_size;
+    }
+
+    // handlers expect blending to be disabled, the rest of the state is left
+    // bound for the next pass
+    gl_state_.Disable(GL_BLEND);
+
+    if (profiler_) {
+      profiler_->EndComposite();
+    }
+  }
+
+  instances_.clear();
+  layer_copies_.clear();
+  shelf_pos_x_ = 0;
+  shelf_pos_y_ = 0;
+  shelf_height_ = 0;
+  used_width_ = 0;
+}
+
+[[nodiscard]] bool Compositor::TryAllocate(SizeType width, SizeType height,
+                                           Area &result) noexcept {
+  if (shelf_pos_x_ + width > atlas_width_) {
+    shelf_pos_x_ = 0;
+    shelf_pos_y_ += shelf_height_;
+    shelf_height_ = 0;
+  }
+  if (shelf_pos_y_ + height > atlas_height_) {
+    return false;
+  }
+
+  result = {shelf_pos_x_, shelf_pos_y_, width, height};
+
+  shelf_pos_x_ += width;
+  shelf_height_ = std::max(shelf_height_, height);
+  used_width_ = std::max(used_width_, shelf_pos_x_);
+  return true;
+}
+
+}  // namespace graphics
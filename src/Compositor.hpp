@@ -0,0 +1,101 @@
+#ifndef COMPOSITOR_HPP
+#define COMPOSITOR_HPP
+
+#include "GLStateCache.hpp"
+#include "PDH_GLFW_OpenGL.hpp"
+#include "RenderProfiler.hpp"
+#include "ShaderProgram.hpp"
+#include "StreamingBuffer.hpp"
+#include "TreeBlockAreas.hpp"
+#include "TreeBlockLayer.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+// Class Compositor blends the content of tree blocks into a target
+// framebuffer. Blocks are rendered side by side into an atlas and all the
+// collected rectangles are composited in tree order with a single instanced
+// draw. A new pass is started only when the atlas runs out of space.
+class Compositor {
+ public:
+  Compositor(SizeType max_width, SizeType max_height, GLStateCache &gl_state,
+             StreamingBuffer &stream_buffer) noexcept;
+
+  ~Compositor();
+
+  Compositor(const Compositor &) = delete;
+
+  Compositor &operator=(const Compositor &) = delete;
+
+  // passes are measured if the profiler is supplied
+  void BeginFrame(GLuint target_fbo, const Area &target_area,
+                  const Area &damage_area, RenderProfiler *profiler) noexcept;
+
+  void EndFrame() noexcept;
+
+  // reserves space for a block in the atlas and prepares the atlas for
+  // rendering into the returned area
+  [[nodiscard]] Area AllocateBlock(const Area &area) noexcept;
+
+  // schedules compositing of the content rendered into atlas_area, the content
+  // is also copied into the layer if it is supplied
+  void CompositeBlock(const Area &area, const Area &atlas_area,
+                      TreeBlockLayer *layer) noexcept;
+
+  // schedules compositing of previously rendered layer content
+  void CompositeLayer(const TreeBlockLayer &layer, const Area &area) noexcept;
+
+ private:
+  struct Instance {
+    GLfloat dst_rect[4];  // position and size in the target framebuffer
+    GLfloat src_rect[4];  // position and size in the atlas
+  };
+
+  struct LayerCopy {
+    GLuint layer_texture;
+    Area atlas_area;
+    bool is_to_layer;  // direction of the copy
+  };
+
+  void CreateBuffers() noexcept;
+
+  void Flush() noexcept;
+
+  [[nodiscard]] bool TryAllocate(SizeType width, SizeType height,
+                                 Area &result) noexcept;
+
+  const SizeType atlas_width_;
+  const SizeType atlas_height_;
+  GLStateCache &gl_state_;
+  StreamingBuffer &stream_buffer_;  // instance data of every pass
+
+  GLuint render_fbo_;      // handlers render here, multisampled if the default
+                           // framebuffer is multisampled
+  GLuint color_rbo_;
+  GLuint depth_stencil_rbo_;
+  GLuint atlas_fbo_;       // resolved content of render_fbo_
+  GLuint atlas_texture_;
+  GLuint vao_;
+
+  ShaderProgram sp_;
+  GLint target_size_location_;
+  GLint atlas_size_location_;
+
+  // the atlas is filled with shelves of blocks from the bottom to the top
+  SizeType shelf_pos_x_;
+  SizeType shelf_pos_y_;
+  SizeType shelf_height_;
+  SizeType used_width_;
+
+  GLuint target_fbo_;
+  Area target_area_;
+  Area damage_area_;
+  RenderProfiler *profiler_;
+
+  Vector<Instance> instances_;
+  Vector<LayerCopy> layer_copies_;
+};
+
+}  // namespace graphics
+
+#endif  // COMPOSITOR_HPP
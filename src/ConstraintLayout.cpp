@@ -0,0 +1,226 @@
+#include "ConstraintLayout.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace graphics {
+
+ConstraintLayout::ConstraintLayout() noexcept
+    : solver_{}, container_{}, blocks_{} {
+  container_.left = solver_.CreateVariable();
+  container_.top = solver_.CreateVariable();
+  container_.width = solver_.CreateVariable();
+  container_.height = solver_.CreateVariable();
+
+  // the area of the block is suggested on every Compute, it yields only to
+  // required constraints
+  constexpr auto container_strength{Strength::kStrong * 1000.};
+  for (auto variable : {container_.left, container_.top, container_.width,
+                        container_.height}) {
+    static_cast<void>(solver_.AddEditVariable(variable, container_strength));
+  }
+}
+
+[[nodiscard]] bool ConstraintLayout::AddConstraint(
+    LayoutAnchor first, Relation relation, LayoutAnchor second,
+    double multiplier, double constant, double strength,
+    ConstraintId &id) noexcept {
+  Expression expression{{}, -constant};
+  AppendAnchor(first, 1., expression);
+  AppendAnchor(second, -multiplier, expression);
+
+  Invalidate();
+  return solver_.AddConstraint(expression, relation, strength, id);
+}
+
+[[nodiscard]] bool ConstraintLayout::AddConstraint(
+    LayoutAnchor first, Relation relation, double constant, double strength,
+    ConstraintId &id) noexcept {
+  Expression expression{{}, -constant};
+  AppendAnchor(first, 1., expression);
+
+  Invalidate();
+  return solver_.AddConstraint(expression, relation, strength, id);
+}
+
+void ConstraintLayout::RemoveConstraint(ConstraintId id) noexcept {
+  solver_.RemoveConstraint(id);
+  Invalidate();
+}
+
+[[nodiscard]] bool ConstraintLayout::BeginEdit(LayoutAnchor anchor,
+                                               double strength) noexcept {
+  Variable variable{};
+  if (!anchor.block || !GetEditableVariable(anchor, variable)) {
+    return false;
+  }
+
+  return solver_.AddEditVariable(variable, strength);
+}
+
+void ConstraintLayout::SuggestValue(LayoutAnchor anchor,
+                                    double value) noexcept {
+  Variable variable{};
+  if (anchor.block && GetEditableVariable(anchor, variable)) {
+    solver_.SuggestValue(variable, value);
+    Invalidate();
+  }
+}
+
+void ConstraintLayout::EndEdit(LayoutAnchor anchor) noexcept {
+  Variable variable{};
+  if (anchor.block && GetEditableVariable(anchor, variable)) {
+    solver_.RemoveEditVariable(variable);
+    Invalidate();
+  }
+}
+
+void ConstraintLayout::Compute(const Area &container,
+                               const List<TreeBlock *> &children,
+                               Vector<Area> &areas) noexcept {
+  // values equal to the previous ones are skipped by the solver, so a resize
+  // only repairs the rows depending on the changed sides of the block
+  solver_.SuggestValue(container_.left, static_cast<double>(container.pos_x));
+  solver_.SuggestValue(container_.top, static_cast<double>(container.pos_y));
+  solver_.SuggestValue(container_.width, static_cast<double>(container.width));
+  solver_.SuggestValue(container_.height,
+                       static_cast<double>(container.height));
+
+  for (auto child : children) {
+    static_cast<void>(GetVariables(child));
+  }
+  solver_.UpdateVariables();
+
+  // edges are rounded rather than sizes, so adjacent children stay adjacent
+  auto round{[this](Variable variable, SizeType min, SizeType max) {
+    auto value{std::round(solver_.GetValue(variable))};
+    value = std::clamp(value, static_cast<double>(min),
+                       static_cast<double>(max));
+    return static_cast<SizeType>(value);
+  }};
+
+  auto right{container.pos_x + container.width};
+  auto bottom{container.pos_y + container.height};
+  SizeType index{};
+  for (auto child : children) {
+    const auto &variables{blocks_[child]};
+    auto left{round(variables.left, container.pos_x, right)};
+    auto top{round(variables.top, container.pos_y, bottom)};
+
+    auto right_value{solver_.GetValue(variables.left) +
+                     solver_.GetValue(variables.width)};
+    auto bottom_value{solver_.GetValue(variables.top) +
+                      solver_.GetValue(variables.height)};
+    auto child_right{static_cast<SizeType>(std::clamp(
+        std::round(right_value), static_cast<double>(left),
+        static_cast<double>(right)))};
+    auto child_bottom{static_cast<SizeType>(std::clamp(
+        std::round(bottom_value), static_cast<double>(top),
+        static_cast<double>(bottom)))};
+
+    areas[index++] = {left, top, child_right - left, child_bottom - top};
+  }
+}
+
+[[nodiscard]] const ConstraintLayout::BlockVariables &
+ConstraintLayout::GetVariables(const TreeBlock *block) noexcept {
+  if (auto iter{blocks_.find(block)}; iter != blocks_.end()) {
+    return iter->second;
+  }
+
+  BlockVariables variables{solver_.CreateVariable(), solver_.CreateVariable(),
+                           solver_.CreateVariable(), solver_.CreateVariable()};
+
+  // sizes are never negative and the child stays within the block unless
+  // stronger constraints require otherwise
+  ConstraintId id{};
+  static_cast<void>(solver_.AddConstraint({{{variables.width, 1.}}, 0.},
+                                          Relation::kGreaterOrEqual,
+                                          Strength::kRequired, id));
+  static_cast<void>(solver_.AddConstraint({{{variables.height, 1.}}, 0.},
+                                          Relation::kGreaterOrEqual,
+                                          Strength::kRequired, id));
+  static_cast<void>(solver_.AddConstraint(
+      {{{variables.left, 1.}, {container_.left, -1.}}, 0.},
+      Relation::kGreaterOrEqual, Strength::kMedium, id));
+  static_cast<void>(solver_.AddConstraint(
+      {{{variables.top, 1.}, {container_.top, -1.}}, 0.},
+      Relation::kGreaterOrEqual, Strength::kMedium, id));
+  static_cast<void>(solver_.AddConstraint(
+      {{{variables.left, 1.},
+        {variables.width, 1.},
+        {container_.left, -1.},
+        {container_.width, -1.}},
+       0.},
+      Relation::kLessOrEqual, Strength::kMedium, id));
+  static_cast<void>(solver_.AddConstraint(
+      {{{variables.top, 1.},
+        {variables.height, 1.},
+        {container_.top, -1.},
+        {container_.height, -1.}},
+       0.},
+      Relation::kLessOrEqual, Strength::kMedium, id));
+
+  return blocks_.emplace(block, variables).first->second;
+}
+
+[[nodiscard]] bool ConstraintLayout::GetEditableVariable(
+    LayoutAnchor anchor, Variable &variable) noexcept {
+  const auto &variables{anchor.block ? GetVariables(anchor.block)
+                                     : container_};
+  switch (anchor.attribute) {
+    case LayoutAttribute::kLeft:
+      variable = variables.left;
+      return true;
+    case LayoutAttribute::kTop:
+      variable = variables.top;
+      return true;
+    case LayoutAttribute::kWidth:
+      variable = variables.width;
+      return true;
+    case LayoutAttribute::kHeight:
+      variable = variables.height;
+      return true;
+    default:
+      return false;
+  }
+}
+
+void ConstraintLayout::AppendAnchor(LayoutAnchor anchor, double coefficient,
+                                    Expression &expression) noexcept {
+  const auto &variables{anchor.block ? GetVariables(anchor.block)
+                                     : container_};
+  auto &terms{expression.terms};
+  switch (anchor.attribute) {
+    case LayoutAttribute::kLeft:
+      terms.push_back({variables.left, coefficient});
+      break;
+    case LayoutAttribute::kRight:
+      terms.push_back({variables.left, coefficient});
+      terms.push_back({variables.width, coefficient});
+      break;
+    case LayoutAttribute::kTop:
+      terms.push_back({variables.top, coefficient});
+      break;
+    case LayoutAttribute::kBottom:
+      terms.push_back({variables.top, coefficient});
+      terms.push_back({variables.height, coefficient});
+      break;
+    case LayoutAttribute::kWidth:
+      terms.push_back({variables.width, coefficient});
+      break;
+    case LayoutAttribute::kHeight:
+      terms.push_back({variables.height, coefficient});
+      break;
+    case LayoutAttribute::kCenterX:
+      terms.push_back({variables.left, coefficient});
+      terms.push_back({variables.width, coefficient / 2.});
+      break;
+    case LayoutAttribute::kCenterY:
+      terms.push_back({variables.top, coefficient});
+      terms.push_back({variables.height, coefficient / 2.});
+      break;
+  }
+}
+
+}  // namespace graphics
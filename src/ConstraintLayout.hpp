@@ -0,0 +1,100 @@
+#ifndef CONSTRAINTLAYOUT_HPP
+#define CONSTRAINTLAYOUT_HPP
+
+#include <unordered_map>
+
+#include "ConstraintSolver.hpp"
+#include "LayoutBase.hpp"
+#include "TreeBlockAreas.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+class TreeBlock;
+
+enum class LayoutAttribute {
+  kLeft,
+  kRight,
+  kTop,
+  kBottom,
+  kWidth,
+  kHeight,
+  kCenterX,
+  kCenterY
+};
+
+struct LayoutAnchor {
+  const TreeBlock *block;  // nullptr stands for the block owning the layout
+  LayoutAttribute attribute;
+};
+
+// Class ConstraintLayout places the children of a block by relations between
+// them like "left of", "equal width" or "at least 200 pixels wide". The
+// relations are kept by an incremental solver, so a resize of the block or
+// a drag of a child only suggests new values of the edited variables instead
+// of solving all the constraints again. Every child is kept within the block
+// with the medium strength. After the constraints or the suggested values
+// have been changed, TreeBlock::RequestChildrenLayout of the block has to be
+// called.
+class ConstraintLayout : public LayoutBase {
+ public:
+  using ConstraintId = ConstraintSolver::ConstraintId;
+
+  ConstraintLayout() noexcept;
+
+  // adds "first relation second * multiplier + constant", returns false if a
+  // required constraint conflicts with the others
+  [[nodiscard]] bool AddConstraint(LayoutAnchor first, Relation relation,
+                                   LayoutAnchor second, double multiplier,
+                                   double constant, double strength,
+                                   ConstraintId &id) noexcept;
+
+  // adds "first relation constant"
+  [[nodiscard]] bool AddConstraint(LayoutAnchor first, Relation relation,
+                                   double constant, double strength,
+                                   ConstraintId &id) noexcept;
+
+  void RemoveConstraint(ConstraintId id) noexcept;
+
+  // starts editing an anchor of a child, e.g. while it is dragged, only the
+  // left, top, width and height anchors can be edited
+  [[nodiscard]] bool BeginEdit(LayoutAnchor anchor, double strength) noexcept;
+
+  void SuggestValue(LayoutAnchor anchor, double value) noexcept;
+
+  void EndEdit(LayoutAnchor anchor) noexcept;
+
+ protected:
+  void Compute(const Area &container, const List<TreeBlock *> &children,
+               Vector<Area> &areas) noexcept override;
+
+ private:
+  using Variable = ConstraintSolver::Variable;
+  using Expression = ConstraintSolver::Expression;
+
+  struct BlockVariables {
+    Variable left;
+    Variable top;
+    Variable width;
+    Variable height;
+  };
+
+  // creates the variables of a child the first time it is seen
+  [[nodiscard]] const BlockVariables &GetVariables(
+      const TreeBlock *block) noexcept;
+
+  // returns false if the attribute is not a single variable
+  [[nodiscard]] bool GetEditableVariable(LayoutAnchor anchor,
+                                         Variable &variable) noexcept;
+
+  void AppendAnchor(LayoutAnchor anchor, double coefficient,
+                    Expression &expression) noexcept;
+
+  ConstraintSolver solver_;
+  BlockVariables container_;
+  std::unordered_map<const TreeBlock *, BlockVariables> blocks_;
+};
+
+}  // namespace graphics
+
+#endif  // CONSTRAINTLAYOUT_HPP
@@ -0,0 +1,531 @@
+#include "ConstraintSolver.hpp"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace graphics {
+
+[[nodiscard]] bool ConstraintSolver::Symbol::operator<(
+    const Symbol &other) const noexcept {
+  return id < other.id;
+}
+
+double ConstraintSolver::Row::Add(double value) noexcept {
+  return constant += value;
+}
+
+void ConstraintSolver::Row::Insert(const Symbol &symbol,
+                                   double coefficient) noexcept {
+  auto &cell{cells[symbol]};
+  cell += coefficient;
+  if (IsNearZero(cell)) {
+    cells.erase(symbol);
+  }
+}
+
+void ConstraintSolver::Row::Insert(const Row &row,
+                                   double coefficient) noexcept {
+  constant += row.constant * coefficient;
+  for (const auto &[symbol, cell] : row.cells) {
+    Insert(symbol, cell * coefficient);
+  }
+}
+
+void ConstraintSolver::Row::Remove(const Symbol &symbol) noexcept {
+  cells.erase(symbol);
+}
+
+void ConstraintSolver::Row::ReverseSign() noexcept {
+  constant = -constant;
+  for (auto &[symbol, cell] : cells) {
+    cell = -cell;
+  }
+}
+
+void ConstraintSolver::Row::SolveFor(const Symbol &symbol) noexcept {
+  auto iter{cells.find(symbol)};
+  auto coefficient{-1. / iter->second};
+  cells.erase(iter);
+
+  constant *= coefficient;
+  for (auto &[other, cell] : cells) {
+    cell *= coefficient;
+  }
+}
+
+void ConstraintSolver::Row::SolveFor(const Symbol &lhs,
+                                     const Symbol &rhs) noexcept {
+  Insert(lhs, -1.);
+  SolveFor(rhs);
+}
+
+[[nodiscard]] double ConstraintSolver::Row::CoefficientFor(
+    const Symbol &symbol) const noexcept {
+  auto iter{cells.find(symbol)};
+  return iter != cells.end() ? iter->second : 0.;
+}
+
+void ConstraintSolver::Row::Substitute(const Symbol &symbol,
+                                       const Row &row) noexcept {
+  if (auto iter{cells.find(symbol)}; iter != cells.end()) {
+    auto coefficient{iter->second};
+    cells.erase(iter);
+    Insert(row, coefficient);
+  }
+}
+
+ConstraintSolver::ConstraintSolver() noexcept
+    : next_symbol_id_{1},
+      next_constraint_id_{},
+      rows_{},
+      variable_symbols_{},
+      values_{},
+      constraints_{},
+      edits_{},
+      infeasible_rows_{},
+      objective_{},
+      artificial_{},
+      is_artificial_used_{} {}
+
+[[nodiscard]] ConstraintSolver::Variable
+ConstraintSolver::CreateVariable() noexcept {
+  variable_symbols_.push_back(CreateSymbol(SymbolType::kExternal));
+  values_.push_back(0.);
+  return variable_symbols_.size() - 1;
+}
+
+[[nodiscard]] bool ConstraintSolver::AddConstraint(
+    const Expression &expression, Relation relation, double strength,
+    ConstraintId &id) noexcept {
+  Tag tag{};
+  auto row{CreateRow(expression, relation, strength, tag)};
+
+  id = next_constraint_id_++;
+  constraints_.emplace(id, ConstraintInfo{tag, strength});
+
+  auto subject{ChooseSubject(row, tag)};
+  if (subject.type == SymbolType::kInvalid && IsAllDummies(row)) {
+    if (!IsNearZero(row.constant)) {
+      constraints_.erase(id);
+      return false;
+    }
+
+    subject = tag.marker;
+  }
+
+  if (subject.type == SymbolType::kInvalid) {
+    if (!AddWithArtificialVariable(row)) {
+      RemoveConstraint(id);
+      return false;
+    }
+  } else {
+    row.SolveFor(subject);
+    Substitute(subject, row);
+    rows_.emplace(subject, std::move(row));
+  }
+
+  Optimize(objective_);
+  return true;
+}
+
+void ConstraintSolver::RemoveConstraint(ConstraintId id) noexcept {
+  auto iter{constraints_.find(id)};
+  if (iter == constraints_.end()) {
+    return;
+  }
+
+  auto [tag, strength]{iter->second};
+  constraints_.erase(iter);
+
+  RemoveConstraintEffects(tag.marker, strength);
+  RemoveConstraintEffects(tag.other, strength);
+
+  if (auto row_iter{rows_.find(tag.marker)}; row_iter != rows_.end()) {
+    rows_.erase(row_iter);
+  } else if (auto leaving{GetMarkerLeavingSymbol(tag.marker)};
+             leaving.type != SymbolType::kInvalid) {
+    auto leaving_iter{rows_.find(leaving)};
+    auto row{std::move(leaving_iter->second)};
+    rows_.erase(leaving_iter);
+    row.SolveFor(leaving, tag.marker);
+    Substitute(tag.marker, row);
+  }
+
+  Optimize(objective_);
+}
+
+[[nodiscard]] bool ConstraintSolver::AddEditVariable(Variable variable,
+                                                     double strength) noexcept {
+  if (HasEditVariable(variable) || strength >= Strength::kRequired) {
+    return false;
+  }
+
+  ConstraintId id{};
+  if (!AddConstraint({{{variable, 1.}}, 0.}, Relation::kEqual, strength, id)) {
+    return false;
+  }
+
+  edits_.emplace(variable, EditInfo{id, constraints_[id].tag, 0.});
+  return true;
+}
+
+void ConstraintSolver::RemoveEditVariable(Variable variable) noexcept {
+  if (auto iter{edits_.find(variable)}; iter != edits_.end()) {
+    RemoveConstraint(iter->second.constraint);
+    edits_.erase(iter);
+  }
+}
+
+[[nodiscard]] bool ConstraintSolver::HasEditVariable(
+    Variable variable) const noexcept {
+  return edits_.find(variable) != edits_.end();
+}
+
+void ConstraintSolver::SuggestValue(Variable variable, double value) noexcept {
+  auto iter{edits_.find(variable)};
+  if (iter == edits_.end()) {
+    return;
+  }
+
+  auto &info{iter->second};
+  auto delta{value - info.constant};
+  info.constant = value;
+  if (IsNearZero(delta)) {
+    return;
+  }
+
+  // only the rows containing the error variables of the edit constraint are
+  // updated, the rows becoming infeasible are repaired by DualOptimize
+  const auto &[marker, other]{info.tag};
+  if (auto row_iter{rows_.find(marker)}; row_iter != rows_.end()) {
+    if (row_iter->second.Add(-delta) < 0.) {
+      infeasible_rows_.push_back(marker);
+    }
+  } else if (row_iter = rows_.find(other); row_iter != rows_.end()) {
+    if (row_iter->second.Add(delta) < 0.) {
+      infeasible_rows_.push_back(other);
+    }
+  } else {
+    for (auto &[symbol, row] : rows_) {
+      auto coefficient{row.CoefficientFor(marker)};
+      if (coefficient != 0. && row.Add(delta * coefficient) < 0. &&
+          symbol.type != SymbolType::kExternal) {
+        infeasible_rows_.push_back(symbol);
+      }
+    }
+  }
+
+  DualOptimize();
+}
+
+void ConstraintSolver::UpdateVariables() noexcept {
+  for (SizeType i{}; i < variable_symbols_.size(); ++i) {
+    auto iter{rows_.find(variable_symbols_[i])};
+    values_[i] = iter != rows_.end() ? iter->second.constant : 0.;
+  }
+}
+
+[[nodiscard]] double ConstraintSolver::GetValue(
+    Variable variable) const noexcept {
+  return values_[variable];
+}
+
+[[nodiscard]] ConstraintSolver::Symbol ConstraintSolver::CreateSymbol(
+    SymbolType type) noexcept {
+  return {next_symbol_id_++, type};
+}
+
+[[nodiscard]] ConstraintSolver::Row ConstraintSolver::CreateRow(
+    const Expression &expression, Relation relation, double strength,
+    Tag &tag) noexcept {
+  Row row{expression.constant, {}};
+
+  // basic variables are replaced by their rows
+  for (const auto &[variable, coefficient] : expression.terms) {
+    if (IsNearZero(coefficient)) {
+      continue;
+    }
+
+    const auto &symbol{variable_symbols_[variable]};
+    if (auto iter{rows_.find(symbol)}; iter != rows_.end()) {
+      row.Insert(iter->second, coefficient);
+    } else {
+      row.Insert(symbol, coefficient);
+    }
+  }
+
+  auto is_required{strength >= Strength::kRequired};
+  if (relation == Relation::kEqual) {
+    if (is_required) {
+      tag.marker = CreateSymbol(SymbolType::kDummy);
+      row.Insert(tag.marker, 1.);
+    } else {
+      tag.marker = CreateSymbol(SymbolType::kError);
+      tag.other = CreateSymbol(SymbolType::kError);
+      row.Insert(tag.marker, -1.);
+      row.Insert(tag.other, 1.);
+      objective_.Insert(tag.marker, strength);
+      objective_.Insert(tag.other, strength);
+    }
+  } else {
+    auto coefficient{relation == Relation::kLessOrEqual ? 1. : -1.};
+    tag.marker = CreateSymbol(SymbolType::kSlack);
+    row.Insert(tag.marker, coefficient);
+    if (!is_required) {
+      tag.other = CreateSymbol(SymbolType::kError);
+      row.Insert(tag.other, -coefficient);
+      objective_.Insert(tag.other, strength);
+    }
+  }
+
+  if (row.constant < 0.) {
+    row.ReverseSign();
+  }
+
+  return row;
+}
+
+[[nodiscard]] ConstraintSolver::Symbol ConstraintSolver::ChooseSubject(
+    const Row &row, const Tag &tag) const noexcept {
+  for (const auto &[symbol, cell] : row.cells) {
+    if (symbol.type == SymbolType::kExternal) {
+      return symbol;
+    }
+  }
+
+  for (const auto &symbol : {tag.marker, tag.other}) {
+    if ((symbol.type == SymbolType::kSlack ||
+         symbol.type == SymbolType::kError) &&
+        row.CoefficientFor(symbol) < 0.) {
+      return symbol;
+    }
+  }
+
+  return {};
+}
+
+[[nodiscard]] bool ConstraintSolver::AddWithArtificialVariable(
+    const Row &row) noexcept {
+  // the row is feasible if the artificial variable can be driven to zero
+  auto artificial_symbol{CreateSymbol(SymbolType::kSlack)};
+  rows_.emplace(artificial_symbol, row);
+  artificial_ = row;
+  is_artificial_used_ = true;
+  Optimize(artificial_);
+  auto is_feasible{IsNearZero(artificial_.constant)};
+  artificial_ = {};
+  is_artificial_used_ = false;
+
+  if (auto iter{rows_.find(artificial_symbol)}; iter != rows_.end()) {
+    auto artificial_row{std::move(iter->second)};
+    rows_.erase(iter);
+    if (artificial_row.cells.empty()) {
+      return is_feasible;
+    }
+
+    auto entering{GetAnyPivotableSymbol(artificial_row)};
+    if (entering.type == SymbolType::kInvalid) {
+      return false;
+    }
+
+    artificial_row.SolveFor(artificial_symbol, entering);
+    Substitute(entering, artificial_row);
+    rows_.emplace(entering, std::move(artificial_row));
+  }
+
+  for (auto &[symbol, other_row] : rows_) {
+    other_row.Remove(artificial_symbol);
+  }
+  objective_.Remove(artificial_symbol);
+
+  return is_feasible;
+}
+
+void ConstraintSolver::Substitute(const Symbol &symbol,
+                                  const Row &row) noexcept {
+  for (auto &[basic, other_row] : rows_) {
+    other_row.Substitute(symbol, row);
+    if (basic.type != SymbolType::kExternal && other_row.constant < 0.) {
+      infeasible_rows_.push_back(basic);
+    }
+  }
+
+  objective_.Substitute(symbol, row);
+  if (is_artificial_used_) {
+    artificial_.Substitute(symbol, row);
+  }
+}
+
+void ConstraintSolver::Optimize(Row &objective) noexcept {
+  for (;;) {
+    auto entering{GetEnteringSymbol(objective)};
+    if (entering.type == SymbolType::kInvalid) {
+      return;
+    }
+
+    auto leaving{GetLeavingSymbol(entering)};
+    if (leaving.type == SymbolType::kInvalid) {
+      return;
+    }
+
+    auto iter{rows_.find(leaving)};
+    auto row{std::move(iter->second)};
+    rows_.erase(iter);
+    row.SolveFor(leaving, entering);
+    Substitute(entering, row);
+    rows_.emplace(entering, std::move(row));
+  }
+}
+
+void ConstraintSolver::DualOptimize() noexcept {
+  while (!infeasible_rows_.empty()) {
+    auto leaving{infeasible_rows_.back()};
+    infeasible_rows_.pop_back();
+
+    auto iter{rows_.find(leaving)};
+    if (iter == rows_.end() || IsNearZero(iter->second.constant) ||
+        iter->second.constant >= 0.) {
+      continue;
+    }
+
+    auto entering{GetDualEnteringSymbol(iter->second)};
+    if (entering.type == SymbolType::kInvalid) {
+      continue;
+    }
+
+    auto row{std::move(iter->second)};
+    rows_.erase(iter);
+    row.SolveFor(leaving, entering);
+    Substitute(entering, row);
+    rows_.emplace(entering, std::move(row));
+  }
+}
+
+[[nodiscard]] ConstraintSolver::Symbol ConstraintSolver::GetEnteringSymbol(
+    const Row &objective) const noexcept {
+  for (const auto &[symbol, cell] : objective.cells) {
+    if (symbol.type != SymbolType::kDummy && cell < 0.) {
+      return symbol;
+    }
+  }
+
+  return {};
+}
+
+[[nodiscard]] ConstraintSolver::Symbol ConstraintSolver::GetDualEnteringSymbol(
+    const Row &row) const noexcept {
+  Symbol entering{};
+  auto ratio{std::numeric_limits<double>::max()};
+  for (const auto &[symbol, cell] : row.cells) {
+    if (cell > 0. && symbol.type != SymbolType::kDummy) {
+      auto symbol_ratio{objective_.CoefficientFor(symbol) / cell};
+      if (symbol_ratio < ratio) {
+        ratio = symbol_ratio;
+        entering = symbol;
+      }
+    }
+  }
+
+  return entering;
+}
+
+[[nodiscard]] ConstraintSolver::Symbol ConstraintSolver::GetLeavingSymbol(
+    const Symbol &entering) const noexcept {
+  Symbol leaving{};
+  auto ratio{std::numeric_limits<double>::max()};
+  for (const auto &[symbol, row] : rows_) {
+    if (symbol.type == SymbolType::kExternal) {
+      continue;
+    }
+
+    if (auto coefficient{row.CoefficientFor(entering)}; coefficient < 0.) {
+      auto symbol_ratio{-row.constant / coefficient};
+      if (symbol_ratio < ratio) {
+        ratio = symbol_ratio;
+        leaving = symbol;
+      }
+    }
+  }
+
+  return leaving;
+}
+
+[[nodiscard]] ConstraintSolver::Symbol ConstraintSolver::GetMarkerLeavingSymbol(
+    const Symbol &marker) const noexcept {
+  // restricted rows with a negative coefficient are preferred, then the
+  // restricted rows with a positive one, then an unrestricted row
+  Symbol first{};
+  Symbol second{};
+  Symbol third{};
+  auto first_ratio{std::numeric_limits<double>::max()};
+  auto second_ratio{std::numeric_limits<double>::max()};
+  for (const auto &[symbol, row] : rows_) {
+    auto coefficient{row.CoefficientFor(marker)};
+    if (coefficient == 0.) {
+      continue;
+    }
+
+    if (symbol.type == SymbolType::kExternal) {
+      third = symbol;
+    } else if (coefficient < 0.) {
+      if (auto ratio{-row.constant / coefficient}; ratio < first_ratio) {
+        first_ratio = ratio;
+        first = symbol;
+      }
+    } else if (auto ratio{row.constant / coefficient}; ratio < second_ratio) {
+      second_ratio = ratio;
+      second = symbol;
+    }
+  }
+
+  if (first.type != SymbolType::kInvalid) {
+    return first;
+  }
+  if (second.type != SymbolType::kInvalid) {
+    return second;
+  }
+  return third;
+}
+
+void ConstraintSolver::RemoveConstraintEffects(const Symbol &marker,
+                                               double strength) noexcept {
+  if (marker.type != SymbolType::kError) {
+    return;
+  }
+
+  if (auto iter{rows_.find(marker)}; iter != rows_.end()) {
+    objective_.Insert(iter->second, -strength);
+  } else {
+    objective_.Insert(marker, -strength);
+  }
+}
+
+bool ConstraintSolver::IsNearZero(double value) noexcept {
+  constexpr auto eps{1.e-8};
+  return std::abs(value) < eps;
+}
+
+bool ConstraintSolver::IsAllDummies(const Row &row) noexcept {
+  for (const auto &[symbol, cell] : row.cells) {
+    if (symbol.type != SymbolType::kDummy) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+ConstraintSolver::Symbol ConstraintSolver::GetAnyPivotableSymbol(
+    const Row &row) noexcept {
+  for (const auto &[symbol, cell] : row.cells) {
+    if (symbol.type == SymbolType::kSlack ||
+        symbol.type == SymbolType::kError) {
+      return symbol;
+    }
+  }
+
+  return {};
+}
+
+}  // namespace graphics
@@ -0,0 +1,175 @@
+#ifndef CONSTRAINTSOLVER_HPP
+#define CONSTRAINTSOLVER_HPP
+
+#include <map>
+
+#include "Usings.hpp"
+
+namespace graphics {
+
+enum class Relation { kLessOrEqual, kEqual, kGreaterOrEqual };
+
+// strengths of non-required constraints are compared with each other, a
+// required constraint is never violated
+struct Strength {
+  static constexpr double kRequired{1001001000.};
+  static constexpr double kStrong{1000000.};
+  static constexpr double kMedium{1000.};
+  static constexpr double kWeak{1.};
+};
+
+// Class ConstraintSolver is an incremental solver of linear equalities and
+// inequalities based on the Cassowary algorithm. The tableau is kept between
+// the calls, so adding a constraint costs a few pivots and suggesting a new
+// value of an edit variable only repairs the rows depending on the variable
+// with the dual simplex method instead of solving the system from scratch.
+class ConstraintSolver {
+ public:
+  using Variable = SizeType;
+  using ConstraintId = SizeType;
+
+  struct Term {
+    Variable variable;
+    double coefficient;
+  };
+
+  // sum of the terms plus the constant
+  struct Expression {
+    Vector<Term> terms;
+    double constant;
+  };
+
+  ConstraintSolver() noexcept;
+
+  [[nodiscard]] Variable CreateVariable() noexcept;
+
+  // adds the constraint "expression relation 0", returns false if a required
+  // constraint can not be satisfied together with the others
+  [[nodiscard]] bool AddConstraint(const Expression &expression,
+                                   Relation relation, double strength,
+                                   ConstraintId &id) noexcept;
+
+  void RemoveConstraint(ConstraintId id) noexcept;
+
+  // values of edit variables are suggested by SuggestValue, the strength has
+  // to be lower than the required one
+  [[nodiscard]] bool AddEditVariable(Variable variable,
+                                     double strength) noexcept;
+
+  void RemoveEditVariable(Variable variable) noexcept;
+
+  [[nodiscard]] bool HasEditVariable(Variable variable) const noexcept;
+
+  void SuggestValue(Variable variable, double value) noexcept;
+
+  // makes the values of the variables reflect the current solution
+  void UpdateVariables() noexcept;
+
+  [[nodiscard]] double GetValue(Variable variable) const noexcept;
+
+ private:
+  enum class SymbolType { kInvalid, kExternal, kSlack, kError, kDummy };
+
+  struct Symbol {
+    SizeType id;
+    SymbolType type;
+
+    [[nodiscard]] bool operator<(const Symbol &other) const noexcept;
+  };
+
+  // a row of the tableau, the basic symbol of the row equals
+  // constant + sum of the cells
+  struct Row {
+    double constant;
+    std::map<Symbol, double> cells;
+
+    // returns the new constant
+    double Add(double value) noexcept;
+
+    void Insert(const Symbol &symbol, double coefficient) noexcept;
+
+    void Insert(const Row &row, double coefficient) noexcept;
+
+    void Remove(const Symbol &symbol) noexcept;
+
+    void ReverseSign() noexcept;
+
+    // makes the symbol the basic one of the row
+    void SolveFor(const Symbol &symbol) noexcept;
+
+    // pivots the row from the basic symbol lhs to the symbol rhs
+    void SolveFor(const Symbol &lhs, const Symbol &rhs) noexcept;
+
+    [[nodiscard]] double CoefficientFor(const Symbol &symbol) const noexcept;
+
+    void Substitute(const Symbol &symbol, const Row &row) noexcept;
+  };
+
+  struct Tag {
+    Symbol marker;
+    Symbol other;
+  };
+
+  struct ConstraintInfo {
+    Tag tag;
+    double strength;
+  };
+
+  struct EditInfo {
+    ConstraintId constraint;
+    Tag tag;
+    double constant;
+  };
+
+  [[nodiscard]] Symbol CreateSymbol(SymbolType type) noexcept;
+
+  [[nodiscard]] Row CreateRow(const Expression &expression, Relation relation,
+                              double strength, Tag &tag) noexcept;
+
+  [[nodiscard]] Symbol ChooseSubject(const Row &row,
+                                     const Tag &tag) const noexcept;
+
+  [[nodiscard]] bool AddWithArtificialVariable(const Row &row) noexcept;
+
+  void Substitute(const Symbol &symbol, const Row &row) noexcept;
+
+  // the objectives of the solver are bounded, error variables are never
+  // negative and their weights are positive
+  void Optimize(Row &objective) noexcept;
+
+  void DualOptimize() noexcept;
+
+  [[nodiscard]] Symbol GetEnteringSymbol(const Row &objective) const noexcept;
+
+  [[nodiscard]] Symbol GetDualEnteringSymbol(const Row &row) const noexcept;
+
+  [[nodiscard]] Symbol GetLeavingSymbol(const Symbol &entering) const noexcept;
+
+  [[nodiscard]] Symbol GetMarkerLeavingSymbol(
+      const Symbol &marker) const noexcept;
+
+  void RemoveConstraintEffects(const Symbol &marker, double strength) noexcept;
+
+  static bool IsNearZero(double value) noexcept;
+
+  static bool IsAllDummies(const Row &row) noexcept;
+
+  static Symbol GetAnyPivotableSymbol(const Row &row) noexcept;
+
+  SizeType next_symbol_id_;
+  ConstraintId next_constraint_id_;
+
+  std::map<Symbol, Row> rows_;  // the basic symbol and its row
+  Vector<Symbol> variable_symbols_;  // indexed by variables
+  Vector<double> values_;            // indexed by variables
+  std::map<ConstraintId, ConstraintInfo> constraints_;
+  std::map<Variable, EditInfo> edits_;
+  Vector<Symbol> infeasible_rows_;
+  Row objective_;
+  Row artificial_;
+  bool is_artificial_used_;
+};
+
+}  // namespace graphics
+
+#endif  // CONSTRAINTSOLVER_HPP
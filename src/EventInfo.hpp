@@ -19,6 +19,23 @@ enum class KeyModifier : unsigned char {
 
 enum class Action : unsigned char { kPress, kRelease, kUnknown };
 
+// events a block receives, the values are combined by |
+using EventMask = unsigned char;
+
+constexpr EventMask kNoEvents{};
+constexpr EventMask kMouseMovementEvents{1 << 0};
+constexpr EventMask kMouseButtonEvents{1 << 1};
+constexpr EventMask kMouseScrollEvents{1 << 2};
+// the button and scroll events are also received on the way to the block
+// under the cursor, not only when they bubble up from it
+constexpr EventMask kCaptureEvents{1 << 3};
+constexpr EventMask kAllEvents{kMouseMovementEvents | kMouseButtonEvents |
+                               kMouseScrollEvents};
+
+// the button and scroll events go from the root down to the block under the
+// cursor and back up to the root
+enum class EventPhase : unsigned char { kCapture, kTarget, kBubble };
+
 struct MouseButtonEvent {
   MouseButton button;
   KeyModifier mod;
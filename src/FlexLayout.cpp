@@ -0,0 +1,131 @@
+#include "FlexLayout.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "TreeBlock.hpp"
+
+namespace graphics {
+
+FlexLayout::FlexLayout() noexcept
+    : direction_{FlexDirection::kRow},
+      justify_{FlexJustify::kStart},
+      align_{FlexAlign::kStretch},
+      gap_{} {}
+
+void FlexLayout::SetDirection(FlexDirection direction) noexcept {
+  direction_ = direction;
+  Invalidate();
+}
+
+void FlexLayout::SetJustify(FlexJustify justify) noexcept {
+  justify_ = justify;
+  Invalidate();
+}
+
+void FlexLayout::SetAlign(FlexAlign align) noexcept {
+  align_ = align;
+  Invalidate();
+}
+
+void FlexLayout::SetGap(SizeType gap) noexcept {
+  gap_ = gap;
+  Invalidate();
+}
+
+void FlexLayout::Compute(const Area &container,
+                         const List<TreeBlock *> &children,
+                         Vector<Area> &areas) noexcept {
+  if (children.empty()) {
+    return;
+  }
+
+  auto is_row{direction_ == FlexDirection::kRow};
+  auto main_pos{is_row ? container.pos_x : container.pos_y};
+  auto main_size{is_row ? container.width : container.height};
+  auto cross_pos{is_row ? container.pos_y : container.pos_x};
+  auto cross_size{is_row ? container.height : container.width};
+
+  auto gaps{gap_ * (children.size() - 1)};
+  auto available{gaps < main_size ? static_cast<float>(main_size - gaps) : 0.f};
+
+  auto total_basis{0.f};
+  auto total_grow{0.f};
+  auto total_shrink{0.f};
+  for (auto child : children) {
+    const auto &item{child->GetFlexItem()};
+    total_basis += static_cast<float>(item.basis);
+    total_grow += item.grow;
+    total_shrink += item.shrink * static_cast<float>(item.basis);
+  }
+
+  auto free_space{available - total_basis};
+
+  // the free space is distributed by the justification only if no child grows
+  auto offset{0.f};
+  auto spacing{static_cast<float>(gap_)};
+  if (free_space > 0.f && total_grow <= 0.f) {
+    auto rest{free_space};
+    switch (justify_) {
+      case FlexJustify::kCenter:
+        offset = rest / 2.f;
+        break;
+      case FlexJustify::kEnd:
+        offset = rest;
+        break;
+      case FlexJustify::kSpaceBetween:
+        if (children.size() > 1) {
+          spacing += rest / static_cast<float>(children.size() - 1);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  // positions are accumulated as floats and rounded, so the rounding errors
+  // do not add up to a gap at the end of the container
+  auto main_end{static_cast<float>(main_pos + main_size)};
+  auto cursor{static_cast<float>(main_pos) + offset};
+  SizeType index{};
+  for (auto child : children) {
+    const auto &item{child->GetFlexItem()};
+    auto size{static_cast<float>(item.basis)};
+    if (free_space > 0.f && total_grow > 0.f) {
+      size += free_space * item.grow / total_grow;
+    } else if (free_space < 0.f && total_shrink > 0.f) {
+      size += free_space * item.shrink * size / total_shrink;
+    }
+
+    auto begin{std::min(std::round(cursor), main_end)};
+    auto end{std::min(std::round(cursor + std::max(size, 0.f)), main_end)};
+    cursor += std::max(size, 0.f) + spacing;
+
+    auto item_cross_size{std::min(item.cross_size, cross_size)};
+    auto item_cross_pos{cross_pos};
+    switch (align_) {
+      case FlexAlign::kStretch:
+        item_cross_size = cross_size;
+        break;
+      case FlexAlign::kCenter:
+        item_cross_pos += (cross_size - item_cross_size) / 2;
+        break;
+      case FlexAlign::kEnd:
+        item_cross_pos += cross_size - item_cross_size;
+        break;
+      default:
+        break;
+    }
+
+    auto &area{areas[index++]};
+    auto item_main_pos{static_cast<SizeType>(begin)};
+    auto item_main_size{static_cast<SizeType>(end - begin)};
+    if (is_row) {
+      area = {item_main_pos, item_cross_pos, item_main_size, item_cross_size};
+    } else {
+      area = {item_cross_pos, item_main_pos, item_cross_size, item_main_size};
+    }
+  }
+}
+
+}  // namespace graphics
@@ -0,0 +1,56 @@
+#ifndef FLEXLAYOUT_HPP
+#define FLEXLAYOUT_HPP
+
+#include "LayoutBase.hpp"
+#include "TreeBlockAreas.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+class TreeBlock;
+
+enum class FlexDirection { kRow, kColumn };
+
+// distribution of the space left along the main axis
+enum class FlexJustify { kStart, kCenter, kEnd, kSpaceBetween };
+
+// placement of the children along the cross axis
+enum class FlexAlign { kStart, kCenter, kEnd, kStretch };
+
+struct FlexItem {
+  SizeType basis;  // size along the main axis before growing or shrinking
+  float grow;
+  float shrink;  // weighted by the basis like in CSS
+  SizeType cross_size;  // ignored if the children are stretched
+};
+
+// Class FlexLayout places the children of a block in a row or a column, so
+// handlers do not have to position the children in ProcessChangedArea. Every
+// child is described by its FlexItem, see TreeBlock::SetFlexItem.
+class FlexLayout : public LayoutBase {
+ public:
+  FlexLayout() noexcept;
+
+  void SetDirection(FlexDirection direction) noexcept;
+
+  void SetJustify(FlexJustify justify) noexcept;
+
+  void SetAlign(FlexAlign align) noexcept;
+
+  // space between two neighbouring children along the main axis
+  void SetGap(SizeType gap) noexcept;
+
+ protected:
+  void Compute(const Area &container, const List<TreeBlock *> &children,
+               Vector<Area> &areas) noexcept override;
+
+ private:
+  FlexDirection direction_;
+  FlexJustify justify_;
+  FlexAlign align_;
+  SizeType gap_;
+};
+
+}  // namespace graphics
+
+#endif  // FLEXLAYOUT_HPP
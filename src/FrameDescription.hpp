@@ -0,0 +1,33 @@
+#ifndef FRAMEDESCRIPTION_HPP
+#define FRAMEDESCRIPTION_HPP
+
+#include "RenderTreeInfo.hpp"
+#include "TreeBlockAreas.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+class TreeBlock;
+
+struct FrameBlock {
+  TreeBlock *block;
+  Area area;  // area of the block at the moment the frame was built
+  bool is_hovered;
+  bool is_layer_enabled;
+  bool is_layer_valid;  // the content of the layer can be composited again
+};
+
+// Structure FrameDescription is everything the render thread needs to know
+// about a frame. It is produced by RenderTree::BuildFrame and is not changed
+// after that.
+struct FrameDescription {
+  Area window_area;
+  Area damage_area;
+  Vector<FrameBlock> blocks;  // blocks intersecting the damage in tree order
+  MouseInfo mouse_info;
+  bool is_profiled;
+};
+
+}  // namespace graphics
+
+#endif  // FRAMEDESCRIPTION_HPP
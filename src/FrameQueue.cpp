@@ -0,0 +1,51 @@
+#include "FrameQueue.hpp"
+
+#include <utility>
+
+namespace graphics {
+
+FrameQueue::FrameQueue() noexcept
+    : mutex_{}, condition_{}, frame_{}, has_frame_{}, is_stopped_{} {}
+
+[[nodiscard]] bool FrameQueue::IsEmpty() const noexcept {
+  std::lock_guard lock{mutex_};
+  return !has_frame_;
+}
+
+void FrameQueue::Push(FrameDescription &frame) noexcept {
+  {
+    std::lock_guard lock{mutex_};
+    std::swap(frame_, frame);
+    has_frame_ = true;
+  }
+
+  condition_.notify_one();
+}
+
+[[nodiscard]] bool FrameQueue::Pop(FrameDescription &frame) noexcept {
+  std::unique_lock lock{mutex_};
+  condition_.wait(lock, [this]() { return has_frame_ || is_stopped_; });
+  if (!has_frame_) {
+    return false;
+  }
+
+  std::swap(frame_, frame);
+  has_frame_ = false;
+  return true;
+}
+
+void FrameQueue::Stop() noexcept {
+  {
+    std::lock_guard lock{mutex_};
+    is_stopped_ = true;
+  }
+
+  condition_.notify_one();
+}
+
+void FrameQueue::Restart() noexcept {
+  std::lock_guard lock{mutex_};
+  is_stopped_ = false;
+}
+
+}  // namespace graphics
@@ -0,0 +1,46 @@
+#ifndef FRAMEQUEUE_HPP
+#define FRAMEQUEUE_HPP
+
+#include <condition_variable>
+#include <mutex>
+
+#include "FrameDescription.hpp"
+
+namespace graphics {
+
+// Class FrameQueue passes built frames from the event thread to the render
+// thread. It holds at most one frame, so the event thread builds the next
+// frame only after the render thread has taken the previous one. Frames are
+// swapped in and out to reuse their memory.
+class FrameQueue {
+ public:
+  FrameQueue() noexcept;
+
+  FrameQueue(const FrameQueue &) = delete;
+
+  FrameQueue &operator=(const FrameQueue &) = delete;
+
+  [[nodiscard]] bool IsEmpty() const noexcept;
+
+  // the queue must be empty, the frame receives the memory of a consumed one
+  void Push(FrameDescription &frame) noexcept;
+
+  // blocks until a frame is pushed, returns false if the queue is stopped
+  [[nodiscard]] bool Pop(FrameDescription &frame) noexcept;
+
+  void Stop() noexcept;
+
+  void Restart() noexcept;
+
+ private:
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+
+  FrameDescription frame_;
+  bool has_frame_;
+  bool is_stopped_;
+};
+
+}  // namespace graphics
+
+#endif  // FRAMEQUEUE_HPP
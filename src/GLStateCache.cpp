@@ -0,0 +1,205 @@
+#include "GLStateCache.hpp"
+
+namespace graphics {
+
+GLStateCache::GLStateCache() noexcept
+    : program_{},
+      vao_{},
+      draw_fbo_{},
+      read_fbo_{},
+      textures_{},
+      blend_{},
+      scissor_test_{},
+      depth_test_{},
+      stencil_test_{},
+      cull_face_{},
+      blend_func_{},
+      blend_equation_{},
+      viewport_{},
+      scissor_{},
+      clear_color_{},
+      issued_calls_{},
+      elided_calls_{} {}
+
+void GLStateCache::UseProgram(GLuint program) noexcept {
+  if (Update(program_, program)) {
+    glUseProgram(program);
+  }
+}
+
+void GLStateCache::BindVertexArray(GLuint vao) noexcept {
+  if (Update(vao_, vao)) {
+    glBindVertexArray(vao);
+  }
+}
+
+void GLStateCache::BindFramebuffer(GLenum target, GLuint fbo) noexcept {
+  switch (target) {
+    case GL_DRAW_FRAMEBUFFER:
+      if (Update(draw_fbo_, fbo)) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+      }
+      break;
+    case GL_READ_FRAMEBUFFER:
+      if (Update(read_fbo_, fbo)) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+      }
+      break;
+    default:
+      if (draw_fbo_.is_known && draw_fbo_.value == fbo &&
+          read_fbo_.is_known && read_fbo_.value == fbo) {
+        ++elided_calls_;
+      } else {
+        draw_fbo_ = {fbo, true};
+        read_fbo_ = {fbo, true};
+        ++issued_calls_;
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+      }
+  }
+}
+
+void GLStateCache::BindTextureUnit(GLuint unit, GLuint texture) noexcept {
+  if (unit >= kTrackedTextureUnits) {
+    ++issued_calls_;
+    glBindTextureUnit(unit, texture);
+  } else if (Update(textures_[unit], texture)) {
+    glBindTextureUnit(unit, texture);
+  }
+}
+
+void GLStateCache::Enable(GLenum cap) noexcept {
+  auto cached{GetCapability(cap)};
+  if (!cached) {
+    ++issued_calls_;
+    glEnable(cap);
+  } else if (Update(*cached, true)) {
+    glEnable(cap);
+  }
+}
+
+void GLStateCache::Disable(GLenum cap) noexcept {
+  auto cached{GetCapability(cap)};
+  if (!cached) {
+    ++issued_calls_;
+    glDisable(cap);
+  } else if (Update(*cached, false)) {
+    glDisable(cap);
+  }
+}
+
+void GLStateCache::BlendFunc(GLenum src_factor, GLenum dst_factor) noexcept {
+  BlendFuncSeparate(src_factor, dst_factor, src_factor, dst_factor);
+}
+
+void GLStateCache::BlendFuncSeparate(GLenum src_rgb, GLenum dst_rgb,
+                                     GLenum src_alpha,
+                                     GLenum dst_alpha) noexcept {
+  if (Update(blend_func_, {src_rgb, dst_rgb, src_alpha, dst_alpha})) {
+    glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+  }
+}
+
+void GLStateCache::BlendEquation(GLenum mode) noexcept {
+  if (Update(blend_equation_, mode)) {
+    glBlendEquation(mode);
+  }
+}
+
+void GLStateCache::Viewport(GLint pos_x, GLint pos_y, GLsizei width,
+                            GLsizei height) noexcept {
+  if (Update(viewport_, {pos_x, pos_y, width, height})) {
+    glViewport(pos_x, pos_y, width, height);
+  }
+}
+
+void GLStateCache::Scissor(GLint pos_x, GLint pos_y, GLsizei width,
+                           GLsizei height) noexcept {
+  if (Update(scissor_, {pos_x, pos_y, width, height})) {
+    glScissor(pos_x, pos_y, width, height);
+  }
+}
+
+void GLStateCache::ClearColor(GLfloat red, GLfloat green, GLfloat blue,
+                              GLfloat alpha) noexcept {
+  if (Update(clear_color_, {red, green, blue, alpha})) {
+    glClearColor(red, green, blue, alpha);
+  }
+}
+
+void GLStateCache::Invalidate() noexcept {
+  program_.is_known = false;
+  vao_.is_known = false;
+  draw_fbo_.is_known = false;
+  read_fbo_.is_known = false;
+  for (auto &texture : textures_) {
+    texture.is_known = false;
+  }
+
+  blend_.is_known = false;
+  scissor_test_.is_known = false;
+  depth_test_.is_known = false;
+  stencil_test_.is_known = false;
+  cull_face_.is_known = false;
+
+  blend_func_.is_known = false;
+  blend_equation_.is_known = false;
+  viewport_.is_known = false;
+  scissor_.is_known = false;
+  clear_color_.is_known = false;
+}
+
+[[nodiscard]] GLuint GLStateCache::GetBoundFramebuffer(
+    GLenum target) const noexcept {
+  if (target == GL_READ_FRAMEBUFFER) {
+    return read_fbo_.value;
+  }
+
+  return draw_fbo_.value;
+}
+
+[[nodiscard]] SizeType GLStateCache::GetIssuedCallsCount() const noexcept {
+  return issued_calls_;
+}
+
+[[nodiscard]] SizeType GLStateCache::GetElidedCallsCount() const noexcept {
+  return elided_calls_;
+}
+
+void GLStateCache::ResetCounters() noexcept {
+  issued_calls_ = 0;
+  elided_calls_ = 0;
+}
+
+template <class T>
+[[nodiscard]] bool GLStateCache::Update(CachedValue<T> &cached,
+                                        const T &value) noexcept {
+  if (cached.is_known && cached.value == value) {
+    ++elided_calls_;
+    return false;
+  }
+
+  cached.value = value;
+  cached.is_known = true;
+  ++issued_calls_;
+  return true;
+}
+
+[[nodiscard]] GLStateCache::CachedValue<bool> *GLStateCache::GetCapability(
+    GLenum cap) noexcept {
+  switch (cap) {
+    case GL_BLEND:
+      return &blend_;
+    case GL_SCISSOR_TEST:
+      return &scissor_test_;
+    case GL_DEPTH_TEST:
+      return &depth_test_;
+    case GL_STENCIL_TEST:
+      return &stencil_test_;
+    case GL_CULL_FACE:
+      return &cull_face_;
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace graphics
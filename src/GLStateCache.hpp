@@ -0,0 +1,99 @@
+#ifndef GLSTATECACHE_HPP
+#define GLSTATECACHE_HPP
+
+#include <array>
+
+#include "PDH_GLFW_OpenGL.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+// Class GLStateCache mirrors the part of the OpenGL state changed by the
+// render path and skips calls that would not change it. All the state changes
+// must go through the cache, otherwise Invalidate() has to be called to make
+// the cache forget what it knows.
+class GLStateCache {
+ public:
+  GLStateCache() noexcept;
+
+  void UseProgram(GLuint program) noexcept;
+
+  void BindVertexArray(GLuint vao) noexcept;
+
+  // GL_FRAMEBUFFER binds both the draw and the read framebuffers
+  void BindFramebuffer(GLenum target, GLuint fbo) noexcept;
+
+  void BindTextureUnit(GLuint unit, GLuint texture) noexcept;
+
+  void Enable(GLenum cap) noexcept;
+
+  void Disable(GLenum cap) noexcept;
+
+  void BlendFunc(GLenum src_factor, GLenum dst_factor) noexcept;
+
+  void BlendFuncSeparate(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha,
+                         GLenum dst_alpha) noexcept;
+
+  void BlendEquation(GLenum mode) noexcept;
+
+  void Viewport(GLint pos_x, GLint pos_y, GLsizei width,
+                GLsizei height) noexcept;
+
+  void Scissor(GLint pos_x, GLint pos_y, GLsizei width,
+               GLsizei height) noexcept;
+
+  void ClearColor(GLfloat red, GLfloat green, GLfloat blue,
+                  GLfloat alpha) noexcept;
+
+  // makes the cache forget the whole state, the next call of every method is
+  // issued
+  void Invalidate() noexcept;
+
+  [[nodiscard]] GLuint GetBoundFramebuffer(GLenum target) const noexcept;
+
+  [[nodiscard]] SizeType GetIssuedCallsCount() const noexcept;
+
+  [[nodiscard]] SizeType GetElidedCallsCount() const noexcept;
+
+  void ResetCounters() noexcept;
+
+ private:
+  template <class T>
+  struct CachedValue {
+    T value;
+    bool is_known;
+  };
+
+  // returns true if the call has to be issued and remembers the new value
+  template <class T>
+  [[nodiscard]] bool Update(CachedValue<T> &cached, const T &value) noexcept;
+
+  [[nodiscard]] CachedValue<bool> *GetCapability(GLenum cap) noexcept;
+
+  constexpr static SizeType kTrackedTextureUnits{16};
+
+  CachedValue<GLuint> program_;
+  CachedValue<GLuint> vao_;
+  CachedValue<GLuint> draw_fbo_;
+  CachedValue<GLuint> read_fbo_;
+  std::array<CachedValue<GLuint>, kTrackedTextureUnits> textures_;
+
+  CachedValue<bool> blend_;
+  CachedValue<bool> scissor_test_;
+  CachedValue<bool> depth_test_;
+  CachedValue<bool> stencil_test_;
+  CachedValue<bool> cull_face_;
+
+  CachedValue<std::array<GLenum, 4>> blend_func_;
+  CachedValue<GLenum> blend_equation_;
+  CachedValue<std::array<GLint, 4>> viewport_;
+  CachedValue<std::array<GLint, 4>> scissor_;
+  CachedValue<std::array<GLfloat, 4>> clear_color_;
+
+  SizeType issued_calls_;
+  SizeType elided_calls_;
+};
+
+}  // namespace graphics
+
+#endif  // GLSTATECACHE_HPP
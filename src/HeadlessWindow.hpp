@@ -0,0 +1,140 @@
+#ifndef HEADLESSWINDOW_HPP
+#define HEADLESSWINDOW_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "RenderTree.hpp"
+#include "TreeBlock.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+enum class ContextApi : unsigned char {
+  kNative,  // WGL, GLX or NSGL, an invisible window is still created
+  kEgl,
+  kOsMesa  // software rendering without a GPU, GLFW has to be built with
+           // OSMesa support and may still need a display server to initialize
+};
+
+// Class HeadlessWindow drives a RenderTree into an offscreen framebuffer
+// instead of a visible window. Rendered frames can be read back, which is
+// used for throughput benchmarks and golden-image tests. Window::InitTools
+// must be called before an instance is created.
+class HeadlessWindow {
+ public:
+  HeadlessWindow(SizeType width, SizeType height, SizeType max_width,
+                 SizeType max_height,
+                 ContextApi context_api = ContextApi::kNative) noexcept
+      : window_ptr_{},
+        render_tree_{},
+        target_fbo_{},
+        target_texture_{},
+        max_width_{max_width},
+        max_height_{max_height} {
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API,
+                   GetGLFWContextCreationApi(context_api));
+    window_ptr_ = glfwCreateWindow(width, height, "", NULL, NULL);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API);
+    if (!window_ptr_) {
+      exit(1);
+    }
+
+    glfwMakeContextCurrent(window_ptr_);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+      std::cout << "Failed to initialize OpenGL context" << std::endl;
+      exit(1);
+    }
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &target_texture_);
+    glTextureStorage2D(target_texture_, 1, GL_RGBA8, max_width_, max_height_);
+    glCreateFramebuffers(1, &target_fbo_);
+    glNamedFramebufferTexture(target_fbo_, GL_COLOR_ATTACHMENT0,
+                              target_texture_, 0);
+    if (glCheckNamedFramebufferStatus(target_fbo_, GL_FRAMEBUFFER) !=
+        GL_FRAMEBUFFER_COMPLETE) {
+      exit(1);
+    }
+
+    render_tree_ =
+        new RenderTree{{0, 0, width, height}, max_width, max_height, nullptr};
+    render_tree_->SetTargetFramebuffer(target_fbo_);
+  }
+
+  ~HeadlessWindow() {
+    glfwMakeContextCurrent(window_ptr_);
+    delete render_tree_;
+    glDeleteFramebuffers(1, &target_fbo_);
+    glDeleteTextures(1, &target_texture_);
+    glfwDestroyWindow(window_ptr_);
+  }
+
+  HeadlessWindow(const HeadlessWindow &) = delete;
+
+  HeadlessWindow &operator=(const HeadlessWindow &) = delete;
+
+  // returns false if nothing had to be rendered
+  bool Render() { return render_tree_->Render(); }
+
+  // repaints the whole tree, handlers are called even if nothing changed
+  void RenderFull() {
+    render_tree_->InvalidateAll();
+    static_cast<void>(render_tree_->Render());
+  }
+
+  // blocks until the GPU finishes all the submitted frames
+  void Finish() { glFinish(); }
+
+  // reads the current window area as tightly packed RGBA rows, the first row
+  // is the bottom one
+  void ReadPixels(Vector<unsigned char> &pixels) {
+    const auto &area{render_tree_->GetRootArea()};
+    pixels.resize(area.width * area.height * 4);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glGetTextureSubImage(target_texture_, 0, area.pos_x, area.pos_y, 0,
+                         area.width, area.height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                         static_cast<GLsizei>(pixels.size()), pixels.data());
+  }
+
+  // the size is limited by the maximum one, the target texture is allocated
+  // for it
+  void Resize(SizeType width, SizeType height) {
+    render_tree_->ChangeArea(
+        {0, 0, std::min(width, max_width_), std::min(height, max_height_)});
+  }
+
+  void InsertAtRoot(TreeBlock *tree_block) {
+    render_tree_->InsertAtRoot(tree_block);
+  }
+
+  // input can be simulated through the tree
+  [[nodiscard]] RenderTree &GetRenderTree() { return *render_tree_; }
+
+ private:
+  static int GetGLFWContextCreationApi(ContextApi context_api) {
+    switch (context_api) {
+      case ContextApi::kEgl:
+        return GLFW_EGL_CONTEXT_API;
+      case ContextApi::kOsMesa:
+        return GLFW_OSMESA_CONTEXT_API;
+      default:
+        return GLFW_NATIVE_CONTEXT_API;
+    }
+  }
+
+  GLFWwindow *window_ptr_;
+  RenderTree *render_tree_;
+
+  GLuint target_fbo_;  // frames are presented here instead of a back buffer
+  GLuint target_texture_;
+  const SizeType max_width_;
+  const SizeType max_height_;
+};
+
+}  // namespace graphics
+
+#endif  // HEADLESSWINDOW_HPP
@@ -0,0 +1,62 @@
+#include "InputQueue.hpp"
+
+namespace graphics {
+
+InputQueue::InputQueue() noexcept : events_{} {}
+
+[[nodiscard]] bool InputQueue::IsEmpty() const noexcept {
+  return events_.empty();
+}
+
+void InputQueue::PushMouseMovement(double pos_x, double pos_y) noexcept {
+  if (!events_.empty() &&
+      events_.back().type == InputEventType::kMouseMovement) {
+    events_.back().pos_x = pos_x;
+    events_.back().pos_y = pos_y;
+    return;
+  }
+
+  events_.push_back({InputEventType::kMouseMovement, pos_x, pos_y, {}});
+}
+
+void InputQueue::PushMouseButton(MouseButtonEvent button_event) noexcept {
+  events_.push_back({InputEventType::kMouseButton, 0., 0., button_event});
+}
+
+void InputQueue::PushMouseScroll(double offset_x, double offset_y) noexcept {
+  if (!events_.empty() && events_.back().type == InputEventType::kMouseScroll) {
+    events_.back().pos_x += offset_x;
+    events_.back().pos_y += offset_y;
+    return;
+  }
+
+  events_.push_back({InputEventType::kMouseScroll, offset_x, offset_y, {}});
+}
+
+void InputQueue::PushCursorLeave() noexcept {
+  events_.push_back({InputEventType::kCursorLeave, 0., 0., {}});
+}
+
+void InputQueue::Dispatch(RenderTree &render_tree) noexcept {
+  for (const auto &event : events_) {
+    switch (event.type) {
+      case InputEventType::kMouseMovement:
+        render_tree.ProcessMouseMovement(
+            event.pos_x, render_tree.GetRootArea().height - event.pos_y);
+        break;
+      case InputEventType::kMouseButton:
+        render_tree.ProcessMouseButton(event.button_event);
+        break;
+      case InputEventType::kMouseScroll:
+        render_tree.ProcessMouseScroll(event.pos_x, event.pos_y);
+        break;
+      case InputEventType::kCursorLeave:
+        render_tree.ProcessCursorLeaveWindow();
+        break;
+    }
+  }
+
+  events_.clear();
+}
+
+}  // namespace graphics
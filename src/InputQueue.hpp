@@ -0,0 +1,57 @@
+#ifndef INPUTQUEUE_HPP
+#define INPUTQUEUE_HPP
+
+#include "EventInfo.hpp"
+#include "RenderTree.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+enum class InputEventType : unsigned char {
+  kMouseMovement,
+  kMouseButton,
+  kMouseScroll,
+  kCursorLeave
+};
+
+struct InputEvent {
+  InputEventType type;
+  // the position of a movement in the window coordinates, Y pointing down,
+  // or the offset of a scroll
+  double pos_x;
+  double pos_y;
+  MouseButtonEvent button_event;
+};
+
+// Class InputQueue buffers the input of a window between frames, so a mouse
+// reporting at a high rate makes one hover and dispatch pass per frame.
+// Consecutive movements are replaced by the last one, the tree computes the
+// cursor offsets from the previously dispatched position, so they accumulate
+// all the skipped movements. Consecutive scrolls are summed. Other events
+// keep their order relative to the movements and scrolls.
+class InputQueue {
+ public:
+  InputQueue() noexcept;
+
+  [[nodiscard]] bool IsEmpty() const noexcept;
+
+  void PushMouseMovement(double pos_x, double pos_y) noexcept;
+
+  void PushMouseButton(MouseButtonEvent button_event) noexcept;
+
+  void PushMouseScroll(double offset_x, double offset_y) noexcept;
+
+  void PushCursorLeave() noexcept;
+
+  // passes the events to the tree in their order and empties the queue. The
+  // Y of a movement is flipped against the root area the tree has when the
+  // event is dispatched, a pending resize of the window is applied by then
+  void Dispatch(RenderTree &render_tree) noexcept;
+
+ private:
+  Vector<InputEvent> events_;
+};
+
+}  // namespace graphics
+
+#endif  // INPUTQUEUE_HPP
@@ -0,0 +1,34 @@
+#include "LayoutBase.hpp"
+
+#include "AreaClamping.hpp"
+
+namespace graphics {
+
+LayoutBase::LayoutBase() noexcept
+    : areas_{}, cached_container_{}, is_valid_{} {}
+
+void LayoutBase::Invalidate() noexcept { is_valid_ = false; }
+
+[[nodiscard]] bool LayoutBase::Update(
+    const Area &container, const List<TreeBlock *> &children) noexcept {
+  if (is_valid_ && container == cached_container_ &&
+      areas_.size() == children.size()) {
+    return false;
+  }
+
+  cached_container_ = container;
+  is_valid_ = true;
+  areas_.resize(children.size());
+  Compute(container, children, areas_);
+
+  // the children stay within the block whatever the layout computes
+  ClampAreasToParent(container, areas_);
+
+  return true;
+}
+
+[[nodiscard]] const Vector<Area> &LayoutBase::GetAreas() const noexcept {
+  return areas_;
+}
+
+}  // namespace graphics
@@ -0,0 +1,47 @@
+#ifndef LAYOUTBASE_HPP
+#define LAYOUTBASE_HPP
+
+#include "TreeBlockAreas.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+class TreeBlock;
+
+// Class LayoutBase places the children of a block. It is evaluated by
+// RenderTree when the area of the block changes. The computed areas are
+// cached and the layout is skipped while neither the area of the block nor
+// the layout itself changes. An instance of the class belongs to a single
+// block.
+class LayoutBase {
+ protected:
+  LayoutBase() noexcept;
+
+  // computes the areas of the children in the order of the children
+  virtual void Compute(const Area &container,
+                       const List<TreeBlock *> &children,
+                       Vector<Area> &areas) noexcept = 0;
+
+ public:
+  virtual ~LayoutBase() = default;
+
+  // forces the next Update to compute the areas again
+  void Invalidate() noexcept;
+
+  // computes the areas of the children within the container, returns false
+  // if the cached areas are still valid
+  [[nodiscard]] bool Update(const Area &container,
+                            const List<TreeBlock *> &children) noexcept;
+
+  // areas computed by the last Update in the order of the children
+  [[nodiscard]] const Vector<Area> &GetAreas() const noexcept;
+
+ private:
+  Vector<Area> areas_;
+  Area cached_container_;
+  bool is_valid_;
+};
+
+}  // namespace graphics
+
+#endif  // LAYOUTBASE_HPP
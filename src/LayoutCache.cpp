@@ -0,0 +1,61 @@
+#include "LayoutCache.hpp"
+
+#include "TreeBlock.hpp"
+
+namespace graphics {
+
+LayoutCache::LayoutCache(SizeType capacity) noexcept
+    : entries_{}, capacity_{capacity}, use_counter_{} {
+  entries_.reserve(capacity_);
+}
+
+[[nodiscard]] const Vector<Area> *LayoutCache::Find(const Area &area) noexcept {
+  for (auto &entry : entries_) {
+    if (entry.area == area) {
+      entry.last_use = ++use_counter_;
+      return &entry.children_areas;
+    }
+  }
+
+  return nullptr;
+}
+
+void LayoutCache::Insert(const Area &area,
+                         const List<TreeBlock *> &children) noexcept {
+  if (capacity_ == 0) {
+    return;
+  }
+
+  // the capacity is small, so the entries are searched linearly
+  Entry *entry{};
+  for (auto &other : entries_) {
+    if (other.area == area) {
+      entry = &other;
+      break;
+    }
+  }
+
+  if (!entry) {
+    if (entries_.size() < capacity_) {
+      entry = &entries_.emplace_back();
+    } else {
+      entry = &entries_.front();
+      for (auto &other : entries_) {
+        if (other.last_use < entry->last_use) {
+          entry = &other;
+        }
+      }
+    }
+  }
+
+  entry->area = area;
+  entry->last_use = ++use_counter_;
+  entry->children_areas.clear();
+  for (auto child : children) {
+    entry->children_areas.push_back(child->GetArea());
+  }
+}
+
+void LayoutCache::Clear() noexcept { entries_.clear(); }
+
+}  // namespace graphics
@@ -0,0 +1,41 @@
+#ifndef LAYOUTCACHE_HPP
+#define LAYOUTCACHE_HPP
+
+#include "TreeBlockAreas.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+class TreeBlock;
+
+// Class LayoutCache remembers the areas the children of a block got for the
+// recent areas of the block. While a window is resized the same sizes recur,
+// so the children are placed by a lookup instead of calling their handlers.
+// The least recently used entry is replaced when the cache is full.
+class LayoutCache {
+ public:
+  explicit LayoutCache(SizeType capacity) noexcept;
+
+  // returns nullptr if the areas are not cached for the area of the block
+  [[nodiscard]] const Vector<Area> *Find(const Area &area) noexcept;
+
+  // stores the current areas of the children for the area of the block
+  void Insert(const Area &area, const List<TreeBlock *> &children) noexcept;
+
+  void Clear() noexcept;
+
+ private:
+  struct Entry {
+    Area area;
+    Vector<Area> children_areas;
+    SizeType last_use;
+  };
+
+  Vector<Entry> entries_;
+  SizeType capacity_;
+  SizeType use_counter_;
+};
+
+}  // namespace graphics
+
+#endif  // LAYOUTCACHE_HPP
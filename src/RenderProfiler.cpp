@@ -0,0 +1,152 @@
+#include "RenderProfiler.hpp"
+
+#include <utility>
+
+namespace graphics {
+
+[[nodiscard]] const BlockTiming *FrameTiming::FindBlockTiming(
+    const TreeBlock *block) const noexcept {
+  for (const auto &block_timing : blocks) {
+    if (block_timing.block == block) {
+      return &block_timing;
+    }
+  }
+
+  return nullptr;
+}
+
+RenderProfiler::RenderProfiler() noexcept
+    : frames_{},
+      frame_index_{},
+      free_queries_{},
+      frame_beg_time_{},
+      section_beg_time_{},
+      frame_timing_{} {}
+
+RenderProfiler::~RenderProfiler() {
+  for (auto &frame : frames_) {
+    free_queries_.insert(free_queries_.end(), frame.block_queries.begin(),
+                         frame.block_queries.end());
+    free_queries_.insert(free_queries_.end(), frame.composite_queries.begin(),
+                         frame.composite_queries.end());
+  }
+
+  if (!free_queries_.empty()) {
+    glDeleteQueries(static_cast<GLsizei>(free_queries_.size()),
+                    free_queries_.data());
+  }
+}
+
+void RenderProfiler::BeginFrame() noexcept {
+  frame_index_ = (frame_index_ + 1) % frames_.size();
+
+  // the slot was used two frames ago, so its results are most likely ready
+  auto &frame{frames_[frame_index_]};
+  if (frame.is_pending) {
+    CollectResults(frame);
+  }
+
+  frame.timing.blocks.clear();
+  frame.timing.cpu_composite_time = {};
+  frame.timing.gpu_composite_time = {};
+  frame_beg_time_ = Clock::now();
+}
+
+void RenderProfiler::EndFrame() noexcept {
+  auto &frame{frames_[frame_index_]};
+  frame.timing.cpu_frame_time = Clock::now() - frame_beg_time_;
+  frame.is_pending = true;
+}
+
+void RenderProfiler::BeginBlock(const TreeBlock *block) noexcept {
+  auto &frame{frames_[frame_index_]};
+  frame.timing.blocks.push_back({block, {}, {}});
+
+  auto query{AcquireQuery()};
+  frame.block_queries.push_back(query);
+  glBeginQuery(GL_TIME_ELAPSED, query);
+
+  section_beg_time_ = Clock::now();
+}
+
+void RenderProfiler::EndBlock() noexcept {
+  auto &frame{frames_[frame_index_]};
+  frame.timing.blocks.back().cpu_render_time =
+      Clock::now() - section_beg_time_;
+
+  glEndQuery(GL_TIME_ELAPSED);
+}
+
+void RenderProfiler::BeginComposite() noexcept {
+  auto &frame{frames_[frame_index_]};
+
+  auto query{AcquireQuery()};
+  frame.composite_queries.push_back(query);
+  glBeginQuery(GL_TIME_ELAPSED, query);
+
+  section_beg_time_ = Clock::now();
+}
+
+void RenderProfiler::EndComposite() noexcept {
+  auto &frame{frames_[frame_index_]};
+  frame.timing.cpu_composite_time += Clock::now() - section_beg_time_;
+
+  glEndQuery(GL_TIME_ELAPSED);
+}
+
+void RenderProfiler::WaitForResults() noexcept {
+  // the older frame goes first, so the newest one ends up in frame_timing_
+  for (SizeType i{1}; i <= frames_.size(); ++i) {
+    auto &frame{frames_[(frame_index_ + i) % frames_.size()]};
+    if (frame.is_pending) {
+      CollectResults(frame);
+    }
+  }
+}
+
+[[nodiscard]] const FrameTiming &RenderProfiler::GetFrameTiming()
+    const noexcept {
+  return frame_timing_;
+}
+
+[[nodiscard]] GLuint RenderProfiler::AcquireQuery() noexcept {
+  if (free_queries_.empty()) {
+    GLuint query;
+    glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+    return query;
+  }
+
+  auto query{free_queries_.back()};
+  free_queries_.pop_back();
+  return query;
+}
+
+void RenderProfiler::CollectResults(MeasuredFrame &frame) noexcept {
+  for (SizeType i{}; i < frame.block_queries.size(); ++i) {
+    frame.timing.blocks[i].gpu_render_time =
+        GetQueryResult(frame.block_queries[i]);
+  }
+  for (auto query : frame.composite_queries) {
+    frame.timing.gpu_composite_time += GetQueryResult(query);
+  }
+
+  free_queries_.insert(free_queries_.end(), frame.block_queries.begin(),
+                       frame.block_queries.end());
+  free_queries_.insert(free_queries_.end(), frame.composite_queries.begin(),
+                       frame.composite_queries.end());
+  frame.block_queries.clear();
+  frame.composite_queries.clear();
+
+  // the vectors are swapped to keep their memory for the next frames
+  std::swap(frame_timing_, frame.timing);
+  frame.is_pending = false;
+}
+
+[[nodiscard]] std::chrono::nanoseconds RenderProfiler::GetQueryResult(
+    GLuint query) noexcept {
+  GLuint64 result{};
+  glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+  return std::chrono::nanoseconds{result};
+}
+
+}  // namespace graphics
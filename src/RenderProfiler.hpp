@@ -0,0 +1,96 @@
+#ifndef RENDERPROFILER_HPP
+#define RENDERPROFILER_HPP
+
+#include <array>
+#include <chrono>
+
+#include "PDH_GLFW_OpenGL.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+class TreeBlock;
+
+struct BlockTiming {
+  const TreeBlock *block;
+  std::chrono::nanoseconds cpu_render_time;  // the handler's Render call
+  std::chrono::nanoseconds gpu_render_time;
+};
+
+struct FrameTiming {
+  Vector<BlockTiming> blocks;  // blocks rendered in the frame in tree order
+
+  // compositing is batched, so it is measured for the whole frame
+  std::chrono::nanoseconds cpu_composite_time;
+  std::chrono::nanoseconds gpu_composite_time;
+
+  std::chrono::nanoseconds cpu_frame_time;
+
+  // returns nullptr if the block was not rendered in the frame
+  [[nodiscard]] const BlockTiming *FindBlockTiming(
+      const TreeBlock *block) const noexcept;
+};
+
+// Class RenderProfiler measures CPU and GPU time of every rendered block.
+// GPU time is measured with GL_TIME_ELAPSED queries whose results are read
+// two frames later, so measuring does not stall the pipeline.
+class RenderProfiler {
+ public:
+  RenderProfiler() noexcept;
+
+  ~RenderProfiler();
+
+  RenderProfiler(const RenderProfiler &) = delete;
+
+  RenderProfiler &operator=(const RenderProfiler &) = delete;
+
+  void BeginFrame() noexcept;
+
+  void EndFrame() noexcept;
+
+  void BeginBlock(const TreeBlock *block) noexcept;
+
+  void EndBlock() noexcept;
+
+  // can be called several times per frame, the time is accumulated
+  void BeginComposite() noexcept;
+
+  void EndComposite() noexcept;
+
+  // reads the results of all the measured frames, stalls until the GPU
+  // finishes them
+  void WaitForResults() noexcept;
+
+  // returns the timing of the last frame whose results have been read
+  [[nodiscard]] const FrameTiming &GetFrameTiming() const noexcept;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct MeasuredFrame {
+    FrameTiming timing;
+    Vector<GLuint> block_queries;  // parallel to timing.blocks
+    Vector<GLuint> composite_queries;
+    bool is_pending;  // the results have not been read yet
+  };
+
+  [[nodiscard]] GLuint AcquireQuery() noexcept;
+
+  void CollectResults(MeasuredFrame &frame) noexcept;
+
+  [[nodiscard]] static std::chrono::nanoseconds GetQueryResult(
+      GLuint query) noexcept;
+
+  std::array<MeasuredFrame, 2> frames_;
+  SizeType frame_index_;
+  Vector<GLuint> free_queries_;
+
+  Clock::time_point frame_beg_time_;
+  Clock::time_point section_beg_time_;
+
+  FrameTiming frame_timing_;
+};
+
+}  // namespace graphics
+
+#endif  // RENDERPROFILER_HPP
@@ -1,13 +1,24 @@
 #ifndef RENDERTREE_HPP
 #define RENDERTREE_HPP
 
+#include <array>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <mutex>
 
+#include "Compositor.hpp"
 #include "EventInfo.hpp"
+#include "FrameDescription.hpp"
+#include "GLStateCache.hpp"
+#include "RenderProfiler.hpp"
 #include "RenderTreeInfo.hpp"
-#include "ShaderProgram.hpp"
+#include "SpatialGrid.hpp"
+#include "StreamingBuffer.hpp"
+#include "ThreadPool.hpp"
 #include "TreeBlockAreas.hpp"
 #include "TreeBlockHandler.hpp"
+#include "TreeBlockLayer.hpp"
 #include "Usings.hpp"
 
 namespace graphics {
@@ -28,36 +39,161 @@ class RenderTree {
 
   RenderTree &operator=(const RenderTree &) = delete;
 
+  // builds and renders a frame on the calling thread
   [[nodiscard]] bool Render() noexcept;
 
+  // describes the next frame and resets the damage, returns false if nothing
+  // has to be rendered
+  [[nodiscard]] bool BuildFrame(FrameDescription &frame) noexcept;
+
+  // executes a built frame, it can be called from a render thread owning the
+  // context of the tree while the event thread keeps changing the tree
+  void RenderFrame(const FrameDescription &frame) noexcept;
+
+  // scales the last rendered frame to the area of the target framebuffer, a
+  // cheap preview while the window is being resized
+  void PresentStretched(const Area &target_area) noexcept;
+
+  [[nodiscard]] bool IsRenderRequired() const noexcept;
+
+  // repaints the whole window in the next frame
+  void InvalidateAll() noexcept;
+
+  // frames are presented into the framebuffer, 0 is the default framebuffer
+  void SetTargetFramebuffer(GLuint fbo) noexcept;
+
+  // the callback is invoked when the tree becomes dirty after a rendered frame
+  void SetRenderRequestCallback(std::function<void()> callback) noexcept;
+
   void InsertAtRoot(TreeBlock *block) noexcept;
 
   void ProcessCursorLeaveWindow() noexcept;
 
   void ProcessMouseMovement(PtrDiff pos_x, PtrDiff pos_y) noexcept;
 
+  // the button and scroll events are routed to the block under the cursor
+  // and its ancestors only, see EventPhase
   void ProcessMouseButton(MouseButtonEvent button_event) noexcept;
 
   void ProcessMouseScroll(PtrDiff offset_x, PtrDiff offset_y) noexcept;
 
   void ChangeArea(Area area) noexcept;
 
+  // in the deferred mode setters of blocks only record what has changed and
+  // the layout and the hover are updated once per frame by UpdateLayout
+  void EnableDeferredLayout() noexcept;
+
+  void DisableDeferredLayout() noexcept;
+
+  // applies the recorded changes, called by BuildFrame before every frame
+  void UpdateLayout() noexcept;
+
+  // changes made between the calls are applied at once by the outermost
+  // EndUpdate: the layout is deferred, the hover is checked once and the
+  // render request callback is invoked once. The calls can be nested, see
+  // also RenderTreeUpdate
+  void BeginUpdate() noexcept;
+
+  void EndUpdate() noexcept;
+
+  // sibling subtrees depend only on the area of their parent, so the ones
+  // whose handlers are all thread-safe for layout are laid out by a pool of
+  // threads. Other handlers are called on the calling thread while no layout
+  // task is running
+  void EnableParallelLayout(SizeType thread_count) noexcept;
+
+  void DisableParallelLayout() noexcept;
+
+  // children of blocks having at least min_children children are indexed by
+  // uniform grids, so the hit testing of wide blocks does not scan all their
+  // children. The grids are built on the first hit test and moved along with
+  // the children
+  void EnableSpatialIndex(SizeType min_children) noexcept;
+
+  void DisableSpatialIndex() noexcept;
+
   [[nodiscard]] const Area &GetRootArea() const noexcept;
 
+  // the cache counts issued and elided calls of the render path
+  [[nodiscard]] GLStateCache &GetGLStateCache() noexcept;
+
+  [[nodiscard]] StreamingBuffer &GetStreamingBuffer() noexcept;
+
+  // frames built while profiling is enabled are measured block by block
+  void EnableProfiling() noexcept;
+
+  void DisableProfiling() noexcept;
+
+  // the profiler belongs to the thread rendering frames
+  [[nodiscard]] RenderProfiler &GetRenderProfiler() noexcept;
+
  private:
-  void ProcessMouseMovement(TreeBlock *block) noexcept;
+  // returns the blocks interested in the mouse movement in the pre-order,
+  // the list is rebuilt after the tree or the masks have changed
+  [[nodiscard]] const Vector<SizeType> &GetMovementListeners() noexcept;
+
+  // returns the index of the block under the cursor or of the root
+  [[nodiscard]] SizeType FindEventTarget() noexcept;
 
-  void ProcessMouseButton(TreeBlock *block) noexcept;
+  // passes the button or scroll event along the path from the root to the
+  // target: down to the parent of the target to the capturing blocks, to the
+  // target itself and back up to the root
+  void RouteMouseEvent(EventMask event, SizeType target) noexcept;
+
+  // returns false if the propagation has been stopped
+  [[nodiscard]] bool DeliverMouseEvent(SizeType index, EventMask event,
+                                       EventPhase phase) noexcept;
 
   void ChangeArea(TreeBlock *block) noexcept;
 
-  void ProcessMouseScroll(TreeBlock *block) noexcept;
+  void ApplyRootArea(const Area &area) noexcept;
+
+  // places the children by the layout of the block or lets every child
+  // process the changed area of the block
+  void LayoutChildren(TreeBlock *block) noexcept;
+
+  // places the children by the areas cached for the area of the block,
+  // returns false if there are no such areas
+  [[nodiscard]] bool ApplyCachedLayout(TreeBlock *block) noexcept;
+
+  // lays the child out on the pool or on the current thread. In a parallel
+  // pass thread-safe children are collected into the run, which is handed
+  // over to the pool once their subtrees are big enough to pay for a task
+  void LayoutChild(TreeBlock *child, Vector<TreeBlock *> &run,
+                   SizeType &run_size) noexcept;
+
+  // enclose every layout started from outside of the layout itself, the end
+  // waits for the layout tasks
+  void BeginLayoutPass() noexcept;
+
+  void EndLayoutPass() noexcept;
+
+  // lays the children out immediately or queues the block for the next
+  // layout update in the deferred mode. Called by a layout task, it lays the
+  // children out on the task's thread, the running pass checks the hover
+  void RequestLayout(TreeBlock *block) noexcept;
+
+  // checks the hover immediately or queues the block for the next layout
+  // update in the deferred mode
+  void ProcessGeometryChange(TreeBlock *block) noexcept;
+
+  void QueueLayout(TreeBlock *block) noexcept;
+
+  // the layout is deferred by the mode or by an update in progress
+  [[nodiscard]] bool IsLayoutDeferred() const noexcept;
 
   void CreateBuffers() noexcept;
 
-  void Render(TreeBlock *block) noexcept;
+  void CollectFrameBlocks(SizeType index, FrameDescription &frame) noexcept;
+
+  // hands the block's content over to the compositor, the handler is called
+  // only if the block has no up-to-date layer
+  void RenderBlock(const FrameBlock &frame_block, const MouseInfo &mouse_info,
+                   RenderProfiler *profiler) noexcept;
 
-  void BlendFBOAndFramebuffer(const Area &area) noexcept;
+  [[nodiscard]] bool RenderMeasured(TreeBlock *block, const Area &viewport,
+                                    const BlockRenderState &state,
+                                    RenderProfiler *profiler) noexcept;
 
   void DisableCheckingHover() noexcept;
 
@@ -65,7 +201,42 @@ class RenderTree {
 
   void CheckHover() noexcept;
 
-  TreeBlock *FindHoveredBlock(TreeBlock *block) const noexcept;
+  // extends the region of the window that has to be repainted in the next
+  // frame
+  void AddDamage(const Area &area) noexcept;
+
+  // revalidates the cached hover path from the top and descends from its
+  // last valid block, so moving within the hovered block costs a few
+  // comparisons per level instead of a search from the root
+  [[nodiscard]] TreeBlock *FindHoveredBlock() noexcept;
+
+  // the block of the path is still the topmost child containing the point
+  [[nodiscard]] bool IsStillHovered(SizeType depth, PtrDiff x,
+                                    PtrDiff y) noexcept;
+
+  // returns true if a later sibling of the block has a common point with it,
+  // the siblings are looked up in the parent's grid if it has one
+  [[nodiscard]] bool IsOverlappedBySibling(SizeType index) noexcept;
+
+  // returns the last child of the block containing the point or kNoBlockIndex
+  [[nodiscard]] SizeType FindChildAt(SizeType index, PtrDiff x,
+                                     PtrDiff y) noexcept;
+
+  // returns the grid of the block if the block has enough children, the grid
+  // is rebuilt if it is invalid
+  [[nodiscard]] SpatialGrid *GetSpatialGrid(SizeType index) noexcept;
+
+  // moves the block within the grid of its parent, the bounds of the block's
+  // own grid are changed with its area
+  void UpdateSpatialIndex(SizeType index, const Area &old_area) noexcept;
+
+  void InvalidateSpatialIndex() noexcept;
+
+  // appends the subtree of the block to the storage, the block has to be the
+  // last child of its parent
+  void AppendToStorage(TreeBlock *block, SizeType parent_index) noexcept;
+
+  void StoreSubtree(TreeBlock *block, SizeType parent_index) noexcept;
 
   friend TreeBlock;
 
@@ -73,16 +244,93 @@ class RenderTree {
   TreeBlock *hovered_block_;
   TreeInfo tree_info_;
 
+  Area damage_area_;  // bounding box of all changes since the last frame
   bool is_render_required_;
+  bool is_profiling_enabled_;
+
+  bool is_layout_deferred_;
+  SizeType update_depth_;  // nesting of BeginUpdate calls
+  bool is_render_request_pending_;
+  bool is_root_area_pending_;
+  bool is_hover_check_pending_;
+  Area pending_root_area_;
+  Vector<TreeBlock *> layout_queue_;  // blocks whose children need a layout
+
+  std::unique_ptr<ThreadPool> layout_pool_;
+  SizeType layout_pass_depth_;
+  bool is_layout_parallel_;  // layout tasks may be running
+  std::mutex damage_mutex_;  // guards the damage while is_layout_parallel_
+  // blocks laid out during a parallel pass are cached when the pass ends,
+  // their children may still be placed by tasks until then
+  Vector<TreeBlock *> blocks_to_cache_;
+  std::mutex cache_mutex_;  // guards blocks_to_cache_
+  std::function<void()> render_request_callback_;
   bool check_hover_;
 
-  GLuint fbo_;            // buffer is to store result of previous rendering
-  GLuint texture_;        // texture is attached to fbo
-  GLuint vao_;            // vao
-  GLuint rectangle_vbo_;  // stores verteces for the texture rectangle
-  GLuint coords_vbo_;
+  // blocks in pre-order indexed by TreeBlock::id_, the subtree of a block
+  // occupies the next subtree_sizes_[id] entries. The arrays mirror the state
+  // of the blocks, so the hit testing and the render traversal walk
+  // contiguous memory instead of the lists of the blocks
+  Vector<TreeBlock *> blocks_;
+  Vector<TreeBlockHandlerBase *> block_handlers_;
+  Vector<Area> block_areas_;
+  Vector<SizeType> parent_indices_;
+  Vector<SizeType> subtree_sizes_;
+  // flags are stored in bytes rather than in packed bits, so layout tasks
+  // can change the flags of different blocks at the same time
+  Vector<unsigned char> opaque_flags_;
+  Vector<unsigned char> parallel_layout_flags_;  // the subtree is thread-safe
+  Vector<EventMask> event_masks_;
+  // scratch of CollectFrameBlocks
+  Vector<SizeType> child_indices_;
+  Vector<SizeType> child_occluder_counts_;
+  Vector<Area> occluder_areas_;
+
+  SizeType spatial_index_min_children_;  // 0 disables the index
+  Vector<std::unique_ptr<SpatialGrid>> spatial_grids_;  // indexed by id
+  Vector<unsigned char> spatial_grid_flags_;  // the grid matches the children
+
+  Vector<SizeType> movement_listeners_;  // indices of interested blocks
+  bool are_movement_listeners_valid_;
+  Vector<SizeType> event_path_;  // the route of the current mouse event
+  bool is_propagation_stopped_;
+  // targets of the presses indexed by MouseButton, the matching releases go
+  // to them wherever the cursor is
+  std::array<SizeType, 3> pressed_blocks_;
+
+  // blocks from a child of the root to the hovered block, a block without
+  // overlapping later siblings stays on top as long as it contains the cursor
+  Vector<SizeType> hover_path_;
+  Vector<bool> hover_path_overlap_flags_;
+  bool is_hover_path_valid_;  // cleared when the geometry changes
+
+  GLuint fbo_;      // buffer is to store result of previous rendering
+  GLuint texture_;  // texture is attached to fbo
+  GLuint target_fbo_;
+  Area presented_area_;  // window area of the last rendered frame
+
+  FrameDescription frame_;  // reused by the single-threaded Render
+
+  GLStateCache gl_state_;
+  StreamingBuffer stream_buffer_;  // per-frame data of the tree and handlers
+  Compositor compositor_;
+  RenderProfiler profiler_;
+};
+
+// Class RenderTreeUpdate begins an update of the tree in the constructor and
+// ends it in the destructor.
+class RenderTreeUpdate {
+ public:
+  explicit RenderTreeUpdate(RenderTree &render_tree) noexcept;
+
+  ~RenderTreeUpdate();
 
-  ShaderProgram sp_;
+  RenderTreeUpdate(const RenderTreeUpdate &) = delete;
+
+  RenderTreeUpdate &operator=(const RenderTreeUpdate &) = delete;
+
+ private:
+  RenderTree &render_tree_;
 };
 
 }  // namespace graphics
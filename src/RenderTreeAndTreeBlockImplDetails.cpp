@@ -1,8 +1,48 @@
+#include <algorithm>
+#include <limits>
+#include <utility>
+
 #include "RenderTree.hpp"
 #include "TreeBlock.hpp"
 
 namespace graphics {
 
+namespace {
+
+constexpr SizeType kStreamingSegmentSize{1 << 20};  // 1 MiB
+constexpr SizeType kStreamingSegmentCount{3};        // frames in flight
+
+constexpr auto kNoBlockIndex{std::numeric_limits<SizeType>::max()};
+
+// smaller subtrees are laid out by the thread reaching them, a task costs
+// more than laying out a few blocks
+constexpr SizeType kMinParallelLayoutSize{64};
+
+[[nodiscard]] bool IsAreaOccluded(const Area &area,
+                                  const Vector<Area> &opaque_areas) noexcept {
+  if (area.IsEmpty()) {
+    return false;
+  }
+
+  for (const auto &opaque_area : opaque_areas) {
+    if (opaque_area.DoesContainArea(area)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// both areas include their right and top edges like in the hit testing
+[[nodiscard]] bool DoAreasTouch(const Area &lhs, const Area &rhs) noexcept {
+  return lhs.pos_x <= rhs.pos_x + rhs.width &&
+         rhs.pos_x <= lhs.pos_x + lhs.width &&
+         lhs.pos_y <= rhs.pos_y + rhs.height &&
+         rhs.pos_y <= lhs.pos_y + lhs.height;
+}
+
+}  // namespace
+
 ////////////IMPLEMENTATION OF THE DEPENDENT PART OF CLASS TreeBlock////////////
 
 RenderTree::RenderTree(Area area, SizeType max_width, SizeType max_height,
@@ -10,18 +50,62 @@ RenderTree::RenderTree(Area area, SizeType max_width, SizeType max_height,
     : root_{new TreeBlock{handler}},
       hovered_block_{},
       tree_info_{max_width, max_height},
+      damage_area_{area},
       is_render_required_{true},
+      is_profiling_enabled_{},
+      is_layout_deferred_{},
+      update_depth_{},
+      is_render_request_pending_{},
+      is_root_area_pending_{},
+      is_hover_check_pending_{},
+      pending_root_area_{},
+      layout_queue_{},
+      layout_pool_{},
+      layout_pass_depth_{},
+      is_layout_parallel_{},
+      damage_mutex_{},
+      blocks_to_cache_{},
+      cache_mutex_{},
+      render_request_callback_{},
       check_hover_{true},
+      blocks_{},
+      block_handlers_{},
+      block_areas_{},
+      parent_indices_{},
+      subtree_sizes_{},
+      opaque_flags_{},
+      parallel_layout_flags_{},
+      event_masks_{},
+      child_indices_{},
+      child_occluder_counts_{},
+      occluder_areas_{},
+      spatial_index_min_children_{},
+      spatial_grids_{},
+      spatial_grid_flags_{},
+      movement_listeners_{},
+      are_movement_listeners_valid_{},
+      event_path_{},
+      is_propagation_stopped_{},
+      pressed_blocks_{},
+      hover_path_{},
+      hover_path_overlap_flags_{},
+      is_hover_path_valid_{},
       fbo_{},
       texture_{},
-      vao_{},
-      rectangle_vbo_{},
-      coords_vbo_{},
-      sp_{"./shaders/rtree/rtree.vs", "./shaders/rtree/rtree.fs"} {
+      target_fbo_{},
+      presented_area_{},
+      frame_{},
+      gl_state_{},
+      stream_buffer_{kStreamingSegmentSize, kStreamingSegmentCount},
+      compositor_{max_width, max_height, gl_state_, stream_buffer_},
+      profiler_{} {
+  root_->render_tree_ = this;
   root_->SetPosX(area.pos_x);
   root_->SetPosY(area.pos_y);
   root_->SetWidth(area.width);
   root_->SetHeight(area.height);
+  AppendToStorage(root_, kNoBlockIndex);
+  pressed_blocks_.fill(kNoBlockIndex);
 
   constexpr auto max_val{std::numeric_limits<PtrDiff>::max()};
   auto &mouse_info{tree_info_.mouse_info};
@@ -32,53 +116,149 @@ RenderTree::RenderTree(Area area, SizeType max_width, SizeType max_height,
 }
 
 [[nodiscard]] bool RenderTree::Render() noexcept {
-  if (is_render_required_) {
-    Render(root_);
-
-    // set back full-screen viewport
-    const auto &cur_window_area{root_->area_};
-    glViewport(cur_window_area.pos_x, cur_window_area.pos_y,
-               cur_window_area.width, cur_window_area.height);
-
-    // copy fbo into default back framebuffer
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
-    glBlitFramebuffer(cur_window_area.pos_x, cur_window_area.pos_y,
-                      cur_window_area.pos_x + cur_window_area.width,
-                      cur_window_area.pos_y + cur_window_area.height,
-                      cur_window_area.pos_x, cur_window_area.pos_y,
-                      cur_window_area.pos_x + cur_window_area.width,
-                      cur_window_area.pos_y + cur_window_area.height,
-                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_);
-    glClearColor(0.f, 0.f, 0.f, 0.f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-
-    is_render_required_ = false;
+  if (BuildFrame(frame_)) {
+    RenderFrame(frame_);
     return true;
   }
 
   return false;
 }
 
+[[nodiscard]] bool RenderTree::BuildFrame(FrameDescription &frame) noexcept {
+  UpdateLayout();
+
+  if (!is_render_required_) {
+    return false;
+  }
+
+  frame.window_area = root_->area_;
+  frame.damage_area = damage_area_.GetIntersection(frame.window_area);
+  frame.blocks.clear();
+  frame.mouse_info = tree_info_.mouse_info;
+  frame.is_profiled = is_profiling_enabled_;
+  if (!frame.damage_area.IsEmpty()) {
+    CollectFrameBlocks(0, frame);
+  }
+
+  damage_area_ = {};
+  is_render_required_ = false;
+  return true;
+}
+
+void RenderTree::RenderFrame(const FrameDescription &frame) noexcept {
+  const auto &cur_window_area{frame.window_area};
+  const auto &damage_area{frame.damage_area};
+  auto profiler{frame.is_profiled ? &profiler_ : nullptr};
+
+  if (profiler) {
+    profiler->BeginFrame();
+  }
+
+  if (!damage_area.IsEmpty()) {
+    // everything outside the damaged region keeps its content from the
+    // previous frames
+    gl_state_.Enable(GL_SCISSOR_TEST);
+    gl_state_.Scissor(damage_area.pos_x, damage_area.pos_y, damage_area.width,
+                      damage_area.height);
+
+    gl_state_.BindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_);
+    gl_state_.ClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    compositor_.BeginFrame(fbo_, cur_window_area, damage_area, profiler);
+    for (const auto &frame_block : frame.blocks) {
+      RenderBlock(frame_block, frame.mouse_info, profiler);
+    }
+    compositor_.EndFrame();
+  }
+
+  // set back full-screen viewport
+  gl_state_.Disable(GL_SCISSOR_TEST);
+  gl_state_.Viewport(cur_window_area.pos_x, cur_window_area.pos_y,
+                     cur_window_area.width, cur_window_area.height);
+
+  // copy fbo into the target framebuffer, the whole window is copied
+  // because the content of the back buffer is undefined after a swap
+  gl_state_.BindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+  gl_state_.BindFramebuffer(GL_DRAW_FRAMEBUFFER, target_fbo_);
+  glBlitFramebuffer(cur_window_area.pos_x, cur_window_area.pos_y,
+                    cur_window_area.pos_x + cur_window_area.width,
+                    cur_window_area.pos_y + cur_window_area.height,
+                    cur_window_area.pos_x, cur_window_area.pos_y,
+                    cur_window_area.pos_x + cur_window_area.width,
+                    cur_window_area.pos_y + cur_window_area.height,
+                    GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  presented_area_ = cur_window_area;
+  stream_buffer_.EndFrame();
+
+  if (profiler) {
+    profiler->EndFrame();
+  }
+}
+
+void RenderTree::PresentStretched(const Area &target_area) noexcept {
+  const auto &area{presented_area_};
+  if (area.IsEmpty() || target_area.IsEmpty()) {
+    return;
+  }
+
+  gl_state_.Disable(GL_SCISSOR_TEST);
+  gl_state_.BindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+  gl_state_.BindFramebuffer(GL_DRAW_FRAMEBUFFER, target_fbo_);
+  glBlitFramebuffer(area.pos_x, area.pos_y, area.pos_x + area.width,
+                    area.pos_y + area.height, target_area.pos_x,
+                    target_area.pos_y, target_area.pos_x + target_area.width,
+                    target_area.pos_y + target_area.height,
+                    GL_COLOR_BUFFER_BIT, GL_LINEAR);
+}
+
+[[nodiscard]] bool RenderTree::IsRenderRequired() const noexcept {
+  return is_render_required_;
+}
+
+void RenderTree::InvalidateAll() noexcept { AddDamage(root_->area_); }
+
+void RenderTree::SetTargetFramebuffer(GLuint fbo) noexcept {
+  target_fbo_ = fbo;
+  InvalidateAll();
+}
+
+void RenderTree::SetRenderRequestCallback(
+    std::function<void()> callback) noexcept {
+  render_request_callback_ = std::move(callback);
+}
+
 void RenderTree::InsertAtRoot(TreeBlock *block) noexcept {
   block->parent_ = root_;
   block->render_tree_ = this;
+  AppendToStorage(block, root_->id_);
   block->SetPosX(block->area_.pos_x);
   block->SetPosY(block->area_.pos_y);
 
+  // anchors set before the insertion could not be resolved without a parent
+  if (block->HasAnchors()) {
+    block->ApplyAnchors();
+  }
+
   const auto &mouse_info{tree_info_.mouse_info};
-  if (block->area_.DoesPointFallWithinArea(mouse_info.cursor_pos_x,
-                                           mouse_info.cursor_pos_y)) {
-    hovered_block_->ProcessHover();
+  if (IsLayoutDeferred()) {
+    is_hover_check_pending_ = true;
+  } else if (block->area_.DoesPointFallWithinArea(mouse_info.cursor_pos_x,
+                                                  mouse_info.cursor_pos_y)) {
+    if (hovered_block_) {
+      hovered_block_->ProcessHover();
+    }
     hovered_block_ = block;
     block->ProcessHover();
   }
 
   root_->children_list_.push_back(block);
-  is_render_required_ = true;
+  AddDamage(block->area_);
+
+  if (root_->layout_) {
+    root_->layout_->Invalidate();
+    RequestLayout(root_);
+  }
 }
 
 void RenderTree::ProcessCursorLeaveWindow() noexcept {
@@ -113,23 +293,127 @@ void RenderTree::ProcessMouseMovement(PtrDiff pos_x, PtrDiff pos_y) noexcept {
   }
   CheckHover();
 
-  root_->ProcessMouseMovement();
-  auto &children_list{root_->GetChildrenList()};
-  for (auto &child : children_list) {
-    ProcessMouseMovement(child);
+  // the list is not changed by insertions made by the handlers, they rebuild
+  // it before the next event
+  const auto &listeners{GetMovementListeners()};
+  for (auto index : listeners) {
+    blocks_[index]->ProcessMouseMovement();
+  }
+}
+
+void RenderTree::ProcessMouseButton(MouseButtonEvent button_event) noexcept {
+  tree_info_.mouse_info.last_mouse_button_event_ = button_event;
+
+  auto button{static_cast<SizeType>(button_event.button)};
+  if (button >= pressed_blocks_.size()) {
+    RouteMouseEvent(kMouseButtonEvents, FindEventTarget());
+    return;
+  }
+
+  // a drag started in a block ends in it even if the cursor has left it
+  auto &pressed_block{pressed_blocks_[button]};
+  if (button_event.action == Action::kRelease &&
+      pressed_block != kNoBlockIndex) {
+    auto target{pressed_block};
+    pressed_block = kNoBlockIndex;
+    RouteMouseEvent(kMouseButtonEvents, target);
+    return;
+  }
+
+  auto target{FindEventTarget()};
+  if (button_event.action == Action::kPress) {
+    pressed_block = target;
   }
+  RouteMouseEvent(kMouseButtonEvents, target);
+}
+
+void RenderTree::ProcessMouseScroll(PtrDiff offset_x,
+                                    PtrDiff offset_y) noexcept {
+  auto &mouse_info{tree_info_.mouse_info};
+  mouse_info.scroll_offset_x = offset_x;
+  mouse_info.scroll_offset_y = offset_y;
+  RouteMouseEvent(kMouseScrollEvents, FindEventTarget());
 }
 
 void RenderTree::ChangeArea(Area area) noexcept {
-  if (auto &root_area{root_->area_}; root_area != area) {
-    root_area = area;
+  if (IsLayoutDeferred()) {
+    pending_root_area_ = area;
+    is_root_area_pending_ = true;
+    AddDamage(area);
+    return;
+  }
+
+  ApplyRootArea(area);
+}
+
+void RenderTree::EnableDeferredLayout() noexcept { is_layout_deferred_ = true; }
+
+void RenderTree::DisableDeferredLayout() noexcept {
+  if (update_depth_ == 0) {
+    UpdateLayout();
+  }
+  is_layout_deferred_ = false;
+}
+
+void RenderTree::BeginUpdate() noexcept { ++update_depth_; }
+
+void RenderTree::EndUpdate() noexcept {
+  if (update_depth_ == 0 || --update_depth_ != 0) {
+    return;
+  }
 
-    auto &root_children{root_->GetChildrenList()};
-    for (auto &child : root_children) {
-      ChangeArea(child);
+  // the deferred mode lays the tree out before the next frame anyway
+  if (!is_layout_deferred_) {
+    UpdateLayout();
+  }
+
+  if (is_render_request_pending_) {
+    is_render_request_pending_ = false;
+    if (render_request_callback_) {
+      render_request_callback_();
     }
+  }
+}
 
-    is_render_required_ = true;
+[[nodiscard]] bool RenderTree::IsLayoutDeferred() const noexcept {
+  return is_layout_deferred_ || update_depth_ != 0;
+}
+
+void RenderTree::UpdateLayout() noexcept {
+  if (is_root_area_pending_) {
+    is_root_area_pending_ = false;
+    ApplyRootArea(pending_root_area_);
+  }
+
+  // the queue can grow while the blocks are laid out, a block that has been
+  // laid out by its parent in this pass is not dirty anymore. The areas of
+  // the queued blocks have been set by the setters or are unchanged, so only
+  // their children are laid out and the handlers of the blocks themselves
+  // are not called, like without the deferral
+  BeginLayoutPass();
+  for (SizeType i{}; i < layout_queue_.size(); ++i) {
+    auto block{layout_queue_[i]};
+    if (block->is_layout_dirty_) {
+      LayoutChildren(block);
+    }
+  }
+  EndLayoutPass();
+
+  // blocks changed again after their turn are kept for the next update, so
+  // handlers that keep moving blocks cannot make the loop endless
+  auto iter{layout_queue_.begin()};
+  for (auto block : layout_queue_) {
+    if (block->is_layout_dirty_) {
+      *iter++ = block;
+    } else {
+      block->is_in_layout_queue_ = false;
+    }
+  }
+  layout_queue_.erase(iter, layout_queue_.end());
+
+  if (is_hover_check_pending_) {
+    is_hover_check_pending_ = false;
+    CheckHover();
   }
 }
 
@@ -137,77 +421,650 @@ void RenderTree::ChangeArea(Area area) noexcept {
   return root_->area_;
 }
 
-void RenderTree::ProcessMouseMovement(TreeBlock *block) noexcept {
-  block->ProcessMouseMovement();
+[[nodiscard]] GLStateCache &RenderTree::GetGLStateCache() noexcept {
+  return gl_state_;
+}
 
-  auto &children_list{block->GetChildrenList()};
-  for (auto &child : children_list) {
-    ProcessMouseMovement(child);
+[[nodiscard]] StreamingBuffer &RenderTree::GetStreamingBuffer() noexcept {
+  return stream_buffer_;
+}
+
+void RenderTree::EnableProfiling() noexcept { is_profiling_enabled_ = true; }
+
+void RenderTree::DisableProfiling() noexcept { is_profiling_enabled_ = false; }
+
+[[nodiscard]] RenderProfiler &RenderTree::GetRenderProfiler() noexcept {
+  return profiler_;
+}
+
+[[nodiscard]] const Vector<SizeType> &
+RenderTree::GetMovementListeners() noexcept {
+  if (!are_movement_listeners_valid_) {
+    movement_listeners_.clear();
+    for (SizeType index{}; index < event_masks_.size(); ++index) {
+      if (event_masks_[index] & kMouseMovementEvents) {
+        movement_listeners_.push_back(index);
+      }
+    }
+    are_movement_listeners_valid_ = true;
   }
+
+  return movement_listeners_;
 }
 
-void RenderTree::ProcessMouseButton(TreeBlock *block) noexcept {
-  block->ProcessMouseButton();
+[[nodiscard]] SizeType RenderTree::FindEventTarget() noexcept {
+  return FindHoveredBlock() ? hover_path_.back() : root_->id_;
+}
 
-  auto &children_list{block->GetChildrenList()};
-  for (auto &child : children_list) {
-    ProcessMouseButton(child);
+void RenderTree::RouteMouseEvent(EventMask event, SizeType target) noexcept {
+  // the route is stored, because the handlers may change the tree
+  event_path_.clear();
+  for (auto index{target}; index != kNoBlockIndex;
+       index = parent_indices_[index]) {
+    event_path_.push_back(index);
+  }
+  std::reverse(event_path_.begin(), event_path_.end());
+  is_propagation_stopped_ = false;
+
+  auto target_depth{event_path_.size() - 1};
+  for (SizeType depth{}; depth < target_depth; ++depth) {
+    if (!DeliverMouseEvent(event_path_[depth], event, EventPhase::kCapture)) {
+      return;
+    }
+  }
+
+  if (!DeliverMouseEvent(event_path_[target_depth], event,
+                         EventPhase::kTarget)) {
+    return;
+  }
+
+  for (auto depth{target_depth}; depth-- > 0;) {
+    if (!DeliverMouseEvent(event_path_[depth], event, EventPhase::kBubble)) {
+      return;
+    }
   }
 }
 
-void RenderTree::ChangeArea(TreeBlock *block) noexcept {
-  auto res{block->ProcessChangedArea()};
+[[nodiscard]] bool RenderTree::DeliverMouseEvent(SizeType index,
+                                                 EventMask event,
+                                                 EventPhase phase) noexcept {
+  auto mask{event_masks_[index]};
+  if (!(mask & event) ||
+      (phase == EventPhase::kCapture && !(mask & kCaptureEvents))) {
+    return true;
+  }
+
+  tree_info_.mouse_info.event_phase = phase;
+  if (event == kMouseButtonEvents) {
+    blocks_[index]->ProcessMouseButton();
+  } else {
+    blocks_[index]->ProcessMouseScroll();
+  }
+  return !is_propagation_stopped_;
+}
 
-  if (res) {
-    auto &block_children{block->GetChildrenList()};
-    for (auto &child : block_children) {
-      ChangeArea(child);
+void RenderTree::ChangeArea(TreeBlock *block) noexcept {
+  // anchored blocks are placed without a virtual call of their handler
+  bool res{};
+  if (block->HasAnchors()) {
+    res = block->SetLayoutArea(block->ResolveAnchors());
+    if (block->is_custom_layout_) {
+      res = block->ProcessChangedArea() || res;
     }
+  } else {
+    res = block->ProcessChangedArea();
+  }
+
+  if (res || block->is_layout_dirty_) {
+    LayoutChildren(block);
+  }
+}
+
+void RenderTree::ApplyRootArea(const Area &area) noexcept {
+  if (auto &root_area{root_->area_}; root_area != area) {
+    auto old_area{root_area};
+    root_area = area;
+    block_areas_[root_->id_] = area;
+    // the root's grid is laid over the old area
+    UpdateSpatialIndex(root_->id_, old_area);
+
+    BeginLayoutPass();
+    LayoutChildren(root_);
+    EndLayoutPass();
+    AddDamage(root_area);
   }
 }
 
-void RenderTree::ProcessMouseScroll(TreeBlock *block) noexcept {
-  block->ProcessMouseScroll();
+void RenderTree::LayoutChildren(TreeBlock *block) noexcept {
+  // the children are up to date, the queued block can be skipped
+  block->is_layout_dirty_ = false;
+
+  auto cache{block->layout_cache_.get()};
+  if (cache && ApplyCachedLayout(block)) {
+    return;
+  }
 
   auto &block_children{block->children_list_};
-  for (auto &child : block_children) {
-    ProcessMouseScroll(child);
+  Vector<TreeBlock *> run;  // used only by parallel passes
+  SizeType run_size{};
+  if (auto layout{block->layout_}; layout) {
+    // the subtrees of children whose area has not changed are skipped
+    if (layout->Update(block->area_, block_children)) {
+      auto area{layout->GetAreas().begin()};
+      for (auto child : block_children) {
+        if (child->SetLayoutArea(*area++)) {
+          LayoutChild(child, run, run_size);
+        }
+      }
+    }
+  } else {
+    for (auto child : block_children) {
+      LayoutChild(child, run, run_size);
+    }
+  }
+
+  // the rest of the run is too small for a task
+  for (auto child : run) {
+    ChangeArea(child);
+  }
+
+  if (!cache) {
+    return;
+  }
+
+  // children laid out by the pool may not be placed yet
+  if (is_layout_parallel_) {
+    std::lock_guard lock{cache_mutex_};
+    blocks_to_cache_.push_back(block);
+  } else {
+    cache->Insert(block->area_, block_children);
   }
 }
 
-void RenderTree::Render(TreeBlock *block) noexcept {
-  if (block->Render()) {
-    BlendFBOAndFramebuffer(block->area_);
+[[nodiscard]] bool RenderTree::ApplyCachedLayout(TreeBlock *block) noexcept {
+  auto &block_children{block->children_list_};
+  auto areas{block->layout_cache_->Find(block->area_)};
+  if (!areas || areas->size() != block_children.size()) {
+    return false;
   }
 
-  const auto &children_list{block->GetChildrenList()};
-  for (auto child : children_list) {
-    Render(child);
+  // the layout no longer matches the areas of the children, so it has to
+  // compute them again on the next miss
+  if (block->layout_) {
+    block->layout_->Invalidate();
   }
+
+  // the handlers of the children are skipped, their areas are already known
+  auto area{areas->begin()};
+  for (auto child : block_children) {
+    if (child->SetLayoutArea(*area++)) {
+      LayoutChildren(child);
+    }
+  }
+
+  return true;
 }
 
-TreeBlock *RenderTree::FindHoveredBlock(TreeBlock *block) const noexcept {
-  if (block->children_list_.empty()) {
-    return nullptr;
+void RenderTree::LayoutChild(TreeBlock *child, Vector<TreeBlock *> &run,
+                             SizeType &run_size) noexcept {
+  if (!is_layout_parallel_) {
+    ChangeArea(child);
+    return;
+  }
+
+  // tasks are given only thread-safe subtrees, so a handler that is not
+  // thread-safe is reached only by the thread that started the layout
+  auto index{child->id_};
+  if (!parallel_layout_flags_[index]) {
+    // ends the run, it is too small for a task
+    for (auto sibling : run) {
+      ChangeArea(sibling);
+    }
+    run.clear();
+    run_size = 0;
+
+    layout_pool_->Wait();
+    ChangeArea(child);
+    return;
+  }
+
+  // a task lays out many small siblings, e.g. the leaves of a wide block
+  run.push_back(child);
+  run_size += subtree_sizes_[index];
+  if (run_size >= kMinParallelLayoutSize) {
+    layout_pool_->Submit([this, siblings{std::move(run)}]() {
+      for (auto sibling : siblings) {
+        ChangeArea(sibling);
+      }
+    });
+    run.clear();
+    run_size = 0;
+  }
+}
+
+void RenderTree::BeginLayoutPass() noexcept {
+  if (layout_pass_depth_++ == 0 && layout_pool_) {
+    is_layout_parallel_ = true;
+  }
+}
+
+void RenderTree::EndLayoutPass() noexcept {
+  if (--layout_pass_depth_ != 0 || !is_layout_parallel_) {
+    return;
+  }
+
+  layout_pool_->Wait();
+  is_layout_parallel_ = false;
+
+  // all the children are placed now
+  for (auto block : blocks_to_cache_) {
+    if (block->layout_cache_) {
+      block->layout_cache_->Insert(block->area_, block->children_list_);
+    }
+  }
+  blocks_to_cache_.clear();
+
+  // the tasks do not move the children within the grids
+  InvalidateSpatialIndex();
+  is_hover_path_valid_ = false;
+
+  // the hover is not checked by the tasks
+  if (IsLayoutDeferred()) {
+    is_hover_check_pending_ = true;
+  } else {
+    CheckHover();
+  }
+}
+
+void RenderTree::EnableParallelLayout(SizeType thread_count) noexcept {
+  if (layout_pass_depth_ == 0) {
+    layout_pool_ = std::make_unique<ThreadPool>(thread_count);
+  }
+}
+
+void RenderTree::DisableParallelLayout() noexcept {
+  if (layout_pass_depth_ == 0) {
+    layout_pool_.reset();
+  }
+}
+
+void RenderTree::EnableSpatialIndex(SizeType min_children) noexcept {
+  spatial_index_min_children_ = std::max<SizeType>(min_children, 1);
+  InvalidateSpatialIndex();
+}
+
+void RenderTree::DisableSpatialIndex() noexcept {
+  spatial_index_min_children_ = 0;
+  spatial_grids_.clear();
+  spatial_grids_.resize(blocks_.size());
+  InvalidateSpatialIndex();
+}
+
+void RenderTree::RequestLayout(TreeBlock *block) noexcept {
+  // the queue, the pass depth and the hover belong to the thread that started
+  // the pass
+  if (is_layout_parallel_) {
+    LayoutChildren(block);
+    return;
+  }
+
+  if (IsLayoutDeferred()) {
+    QueueLayout(block);
+    return;
+  }
+
+  BeginLayoutPass();
+  LayoutChildren(block);
+  EndLayoutPass();
+  CheckHover();
+}
+
+void RenderTree::ProcessGeometryChange(TreeBlock *block) noexcept {
+  // the changed blocks are being laid out and the hover is checked at the end
+  // of the pass
+  if (is_layout_parallel_) {
+    block_areas_[block->id_] = block->area_;
+    return;
+  }
+
+  auto old_area{block_areas_[block->id_]};
+  block_areas_[block->id_] = block->area_;
+  UpdateSpatialIndex(block->id_, old_area);
+  is_hover_path_valid_ = false;
+
+  if (!IsLayoutDeferred()) {
+    CheckHover();
+    return;
+  }
+
+  QueueLayout(block);
+}
+
+void RenderTree::QueueLayout(TreeBlock *block) noexcept {
+  block->is_layout_dirty_ = true;
+  if (!block->is_in_layout_queue_) {
+    block->is_in_layout_queue_ = true;
+    layout_queue_.push_back(block);
+  }
+  is_hover_check_pending_ = true;
+}
+
+void RenderTree::CollectFrameBlocks(SizeType index,
+                                    FrameDescription &frame) noexcept {
+  const auto &damage_area{frame.damage_area};
+
+  // indices of the children are pushed to the shared scratch and popped
+  // before returning, so nested calls do not disturb them
+  auto children_begin{child_indices_.size()};
+  auto subtree_end{index + subtree_sizes_[index]};
+  for (auto child{index + 1}; child < subtree_end;
+       child += subtree_sizes_[child]) {
+    child_indices_.push_back(child);
+  }
+  auto children_end{child_indices_.size()};
+  child_occluder_counts_.resize(children_end);
+
+  // only the damaged part of a block matters, so a block is skipped if that
+  // part is covered by an opaque block drawn after it: a later sibling of the
+  // block or of one of its ancestors, or one of its children. The scratch
+  // holds the occluders inherited from the ancestors, the children are
+  // walked backwards adding the opaque ones, and every child remembers how
+  // many of the occluders are drawn after it
+  auto occluders_begin{occluder_areas_.size()};
+  for (auto i{children_end}; i-- > children_begin;) {
+    auto child{child_indices_[i]};
+    const auto &child_area{block_areas_[child]};
+    child_occluder_counts_[i] = occluder_areas_.size();
+
+    if (opaque_flags_[child] &&
+        !IsAreaOccluded(child_area.GetIntersection(damage_area),
+                        occluder_areas_)) {
+      occluder_areas_.push_back(child_area);
+    }
+  }
+
+  const auto &area{block_areas_[index]};
+  auto visible_area{area.GetIntersection(damage_area)};
+  if (block_handlers_[index] && !visible_area.IsEmpty() &&
+      !IsAreaOccluded(visible_area, occluder_areas_)) {
+    auto block{blocks_[index]};
+    frame.blocks.push_back({block, area, block->hover_,
+                            block->is_layer_enabled_, block->is_layer_valid_});
+
+    // the layer is going to be updated by the render pass
+    if (block->is_layer_enabled_) {
+      block->is_layer_valid_ = true;
+    }
+  }
+
+  // children of a block that does not intersect the damage or is occluded
+  // are still visited, because a child is not guaranteed to lie within its
+  // parent's area. The occluders of a child are a prefix of the ones of the
+  // previous child
+  for (auto i{children_begin}; i < children_end; ++i) {
+    occluder_areas_.resize(child_occluder_counts_[i]);
+    CollectFrameBlocks(child_indices_[i], frame);
+  }
+
+  occluder_areas_.resize(occluders_begin);
+  child_indices_.resize(children_begin);
+  child_occluder_counts_.resize(children_begin);
+}
+
+void RenderTree::RenderBlock(const FrameBlock &frame_block,
+                             const MouseInfo &mouse_info,
+                             RenderProfiler *profiler) noexcept {
+  auto block{frame_block.block};
+  const auto &area{frame_block.area};
+  auto &layer{block->layer_};
+  BlockRenderState state{area, frame_block.is_hovered, &mouse_info, &gl_state_,
+                         &stream_buffer_};
+
+  if (frame_block.is_layer_enabled) {
+    if (frame_block.is_layer_valid && layer.GetWidth() == area.width &&
+        layer.GetHeight() == area.height) {
+      if (block->is_layer_has_content_) {
+        compositor_.CompositeLayer(layer, area);
+      }
+      return;
+    }
+
+    layer.Resize(area.width, area.height);
+
+    auto atlas_area{compositor_.AllocateBlock(area)};
+    block->is_layer_has_content_ =
+        RenderMeasured(block, atlas_area, state, profiler);
+    if (block->is_layer_has_content_) {
+      compositor_.CompositeBlock(area, atlas_area, &layer);
+    }
+    return;
+  }
+
+  // the layer of a disabled retained mode is released by the thread owning
+  // the context
+  if (layer.IsAllocated()) {
+    layer.Release();
   }
 
-  auto iter{block->children_list_.rbegin()};
-  auto end_iter{block->children_list_.rend()};
+  auto atlas_area{compositor_.AllocateBlock(area)};
+  if (RenderMeasured(block, atlas_area, state, profiler)) {
+    compositor_.CompositeBlock(area, atlas_area, nullptr);
+  }
+}
+
+[[nodiscard]] bool RenderTree::RenderMeasured(
+    TreeBlock *block, const Area &viewport, const BlockRenderState &state,
+    RenderProfiler *profiler) noexcept {
+  if (!profiler) {
+    return block->Render(viewport, state);
+  }
+
+  profiler->BeginBlock(block);
+  auto result{block->Render(viewport, state)};
+  profiler->EndBlock();
+  return result;
+}
+
+[[nodiscard]] TreeBlock *RenderTree::FindHoveredBlock() noexcept {
   const auto &mouse_info{tree_info_.mouse_info};
+  auto x{mouse_info.cursor_pos_x};
+  auto y{mouse_info.cursor_pos_y};
 
-  while (iter != end_iter) {
-    if ((*iter)->area_.DoesPointFallWithinArea(mouse_info.cursor_pos_x,
-                                               mouse_info.cursor_pos_y)) {
-      if (auto result{FindHoveredBlock(*iter)}; result) {
-        return result;
-      } else {
-        return *iter;
+  SizeType depth{};
+  if (is_hover_path_valid_) {
+    while (depth < hover_path_.size() && IsStillHovered(depth, x, y)) {
+      ++depth;
+    }
+  }
+  hover_path_.resize(depth);
+  hover_path_overlap_flags_.resize(depth);
+  is_hover_path_valid_ = true;
+
+  // the last child containing the cursor is the topmost one, the search goes
+  // down into it until a block without such children is found
+  auto index{depth ? hover_path_.back() : root_->id_};
+  for (;;) {
+    auto hovered_index{FindChildAt(index, x, y)};
+    if (hovered_index == kNoBlockIndex) {
+      break;
+    }
+
+    hover_path_.push_back(hovered_index);
+    hover_path_overlap_flags_.push_back(IsOverlappedBySibling(hovered_index));
+    index = hovered_index;
+  }
+
+  return hover_path_.empty() ? nullptr : blocks_[hover_path_.back()];
+}
+
+[[nodiscard]] bool RenderTree::IsStillHovered(SizeType depth, PtrDiff x,
+                                              PtrDiff y) noexcept {
+  auto index{hover_path_[depth]};
+  if (!block_areas_[index].DoesPointFallWithinArea(x, y)) {
+    return false;
+  }
+
+  if (!hover_path_overlap_flags_[depth]) {
+    return true;
+  }
+
+  auto parent{depth ? hover_path_[depth - 1] : root_->id_};
+  return FindChildAt(parent, x, y) == index;
+}
+
+[[nodiscard]] bool RenderTree::IsOverlappedBySibling(SizeType index) noexcept {
+  auto parent{parent_indices_[index]};
+  const auto &area{block_areas_[index]};
+
+  // a sibling touching the block shares a cell with it unless the block
+  // sticks out of the grid's bounds
+  if (auto grid{GetSpatialGrid(parent)};
+      grid && block_areas_[parent].DoesContainArea(area)) {
+    return grid->IsAnyNear(area, [this, index, &area](SizeType sibling) {
+      return sibling > index && DoAreasTouch(area, block_areas_[sibling]);
+    });
+  }
+
+  auto parent_end{parent + subtree_sizes_[parent]};
+  for (auto sibling{index + subtree_sizes_[index]}; sibling < parent_end;
+       sibling += subtree_sizes_[sibling]) {
+    if (DoAreasTouch(area, block_areas_[sibling])) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+[[nodiscard]] SizeType RenderTree::FindChildAt(SizeType index, PtrDiff x,
+                                               PtrDiff y) noexcept {
+  auto hovered_index{kNoBlockIndex};
+
+  // children are stored in their order, so the largest candidate index is the
+  // topmost child. A point outside of the grid's bounds is looked up linearly
+  if (auto grid{GetSpatialGrid(index)}) {
+    if (auto candidates{grid->Find(x, y)}) {
+      for (auto child : *candidates) {
+        if ((hovered_index == kNoBlockIndex || child > hovered_index) &&
+            block_areas_[child].DoesPointFallWithinArea(x, y)) {
+          hovered_index = child;
+        }
       }
+      return hovered_index;
+    }
+  }
+
+  auto subtree_end{index + subtree_sizes_[index]};
+  for (auto child{index + 1}; child < subtree_end;
+       child += subtree_sizes_[child]) {
+    if (block_areas_[child].DoesPointFallWithinArea(x, y)) {
+      hovered_index = child;
+    }
+  }
+  return hovered_index;
+}
+
+[[nodiscard]] SpatialGrid *RenderTree::GetSpatialGrid(SizeType index) noexcept {
+  if (!spatial_index_min_children_ ||
+      blocks_[index]->children_list_.size() < spatial_index_min_children_) {
+    return nullptr;
+  }
+
+  auto &grid{spatial_grids_[index]};
+  if (grid && spatial_grid_flags_[index]) {
+    return grid.get();
+  }
+
+  if (!grid) {
+    grid = std::make_unique<SpatialGrid>();
+  }
+
+  grid->Reset(block_areas_[index], blocks_[index]->children_list_.size());
+  auto subtree_end{index + subtree_sizes_[index]};
+  for (auto child{index + 1}; child < subtree_end;
+       child += subtree_sizes_[child]) {
+    grid->Insert(child, block_areas_[child]);
+  }
+  spatial_grid_flags_[index] = true;
+  return grid.get();
+}
+
+void RenderTree::UpdateSpatialIndex(SizeType index,
+                                    const Area &old_area) noexcept {
+  if (!spatial_index_min_children_) {
+    return;
+  }
+
+  const auto &area{block_areas_[index]};
+
+  // the cells of the block's own grid are laid over its area
+  if (!(old_area == area)) {
+    spatial_grid_flags_[index] = false;
+  }
+
+  auto parent{parent_indices_[index]};
+  if (parent == kNoBlockIndex || !spatial_grid_flags_[parent]) {
+    return;
+  }
+
+  auto &grid{spatial_grids_[parent]};
+  grid->Remove(index, old_area);
+  grid->Insert(index, area);
+}
+
+void RenderTree::InvalidateSpatialIndex() noexcept {
+  spatial_grid_flags_.assign(blocks_.size(), false);
+}
+
+void RenderTree::AppendToStorage(TreeBlock *block,
+                                 SizeType parent_index) noexcept {
+  auto index{blocks_.size()};
+  StoreSubtree(block, parent_index);
+
+  // the grid of the parent is rebuilt with the new child
+  if (parent_index != kNoBlockIndex) {
+    spatial_grid_flags_[parent_index] = false;
+  }
+  is_hover_path_valid_ = false;
+  are_movement_listeners_valid_ = false;
+
+  // the appended subtree is the last one, so it extends all its ancestors
+  auto size{subtree_sizes_[index]};
+  bool is_thread_safe{parallel_layout_flags_[index] != 0};
+  for (auto ancestor{parent_index}; ancestor != kNoBlockIndex;
+       ancestor = parent_indices_[ancestor]) {
+    subtree_sizes_[ancestor] += size;
+    if (!is_thread_safe) {
+      parallel_layout_flags_[ancestor] = false;
     }
-    ++iter;
   }
 }
 
+void RenderTree::StoreSubtree(TreeBlock *block,
+                              SizeType parent_index) noexcept {
+  auto index{blocks_.size()};
+  block->id_ = index;
+  blocks_.push_back(block);
+  block_handlers_.push_back(block->handler_);
+  block_areas_.push_back(block->area_);
+  parent_indices_.push_back(parent_index);
+  subtree_sizes_.push_back(1);
+  opaque_flags_.push_back(block->is_opaque_);
+  parallel_layout_flags_.push_back(!block->handler_ ||
+                                   block->handler_->IsLayoutThreadSafe());
+  event_masks_.push_back(block->GetEffectiveEventMask());
+  spatial_grids_.emplace_back();
+  spatial_grid_flags_.push_back(false);
+
+  for (auto child : block->children_list_) {
+    StoreSubtree(child, index);
+    if (!parallel_layout_flags_[child->id_]) {
+      parallel_layout_flags_[index] = false;
+    }
+  }
+  subtree_sizes_[index] = blocks_.size() - index;
+}
+
 void RenderTree::CheckHover() noexcept {
   if (!check_hover_) {
     return;
@@ -216,13 +1073,13 @@ void RenderTree::CheckHover() noexcept {
   auto &mouse_info{tree_info_.mouse_info};
 
   if (!hovered_block_) {  // case when the curosor entered the window
-    hovered_block_ = FindHoveredBlock(root_);
+    hovered_block_ = FindHoveredBlock();
     if (hovered_block_) {
       hovered_block_->ProcessHover();
     }
   } else if (hovered_block_->area_.DoesPointFallWithinArea(
                  mouse_info.cursor_pos_x, mouse_info.cursor_pos_y)) {
-    auto possible_hovered_block{FindHoveredBlock(root_)};
+    auto possible_hovered_block{FindHoveredBlock()};
     if (possible_hovered_block != hovered_block_) {
       hovered_block_->ProcessHover();
       hovered_block_ = possible_hovered_block;
@@ -230,18 +1087,86 @@ void RenderTree::CheckHover() noexcept {
     }
   } else {
     hovered_block_->ProcessHover();
-    hovered_block_ = FindHoveredBlock(root_);
+    hovered_block_ = FindHoveredBlock();
     if (hovered_block_) {
       hovered_block_->ProcessHover();
     }
   }
 }
 
+void RenderTree::AddDamage(const Area &area) noexcept {
+  if (area.IsEmpty()) {
+    return;
+  }
+
+  // layout tasks damage their blocks from the threads of the pool
+  std::unique_lock lock{damage_mutex_, std::defer_lock};
+  if (is_layout_parallel_) {
+    lock.lock();
+  }
+
+  if (is_render_required_) {
+    damage_area_ = damage_area_.GetUnion(area);
+  } else {
+    damage_area_ = area;
+    is_render_required_ = true;
+
+    if (update_depth_ != 0) {
+      is_render_request_pending_ = true;
+    } else if (render_request_callback_) {
+      render_request_callback_();
+    }
+  }
+}
+
 ////////////IMPLEMENTATION OF THE DEPENDENT PART OF CLASS TreeBlock////////////
 
+void TreeBlock::SetLayout(LayoutBase *layout) noexcept {
+  layout_ = layout;
+  RequestChildrenLayout();
+}
+
+void TreeBlock::SetFlexItem(const FlexItem &item) noexcept {
+  flex_item_ = item;
+  if (parent_) {
+    parent_->RequestChildrenLayout();
+  }
+}
+
+void TreeBlock::RequestChildrenLayout() noexcept {
+  if (layout_) {
+    layout_->Invalidate();
+  }
+  InvalidateLayoutCache();
+
+  if (render_tree_) {
+    render_tree_->RequestLayout(this);
+  }
+}
+
+[[nodiscard]] bool TreeBlock::SetLayoutArea(const Area &area) noexcept {
+  if (area_ == area) {
+    return false;
+  }
+
+  auto old_area{area_};
+  area_ = area;
+  if (render_tree_) {
+    render_tree_->ProcessGeometryChange(this);
+    render_tree_->AddDamage(old_area);
+    render_tree_->AddDamage(area_);
+  }
+
+  // the block has been moved, so its children follow it even if its handler
+  // leaves the area untouched
+  is_layout_dirty_ = true;
+
+  return true;
+}
+
 void TreeBlock::SetWidth(SizeType width) noexcept {
   if (parent_) {
-    auto old_width{area_.width};
+    auto old_area{area_};
     const auto &parent_area{parent_->area_};
 
     if (width <= parent_area.width) {
@@ -250,11 +1175,12 @@ void TreeBlock::SetWidth(SizeType width) noexcept {
       area_.width = parent_area.width;
     }
 
-    if (old_width != area_.width) {
+    if (old_area.width != area_.width) {
       CheckAndSetPosX(area_.pos_x);
       if (render_tree_) {
-        render_tree_->CheckHover();
-        render_tree_->is_render_required_ = true;
+        render_tree_->ProcessGeometryChange(this);
+        render_tree_->AddDamage(old_area);
+        render_tree_->AddDamage(area_);
       }
     }
   } else {
@@ -264,7 +1190,7 @@ void TreeBlock::SetWidth(SizeType width) noexcept {
 
 void TreeBlock::SetHeight(SizeType height) noexcept {
   if (parent_) {
-    auto old_height{area_.height};
+    auto old_area{area_};
     const auto &parent_area{parent_->area_};
 
     if (height <= parent_area.height) {
@@ -273,11 +1199,12 @@ void TreeBlock::SetHeight(SizeType height) noexcept {
       area_.height = parent_area.height;
     }
 
-    if (old_height != area_.height) {
+    if (old_area.height != area_.height) {
       CheckAndSetPosY(area_.pos_y);
       if (render_tree_) {
-        render_tree_->CheckHover();
-        render_tree_->is_render_required_ = true;
+        render_tree_->ProcessGeometryChange(this);
+        render_tree_->AddDamage(old_area);
+        render_tree_->AddDamage(area_);
       }
     }
   } else {
@@ -287,13 +1214,14 @@ void TreeBlock::SetHeight(SizeType height) noexcept {
 
 void TreeBlock::SetPosX(SizeType pos_x) noexcept {
   if (parent_) {
-    auto old_pos_x = area_.pos_x;
+    auto old_area{area_};
 
     CheckAndSetPosX(pos_x);
 
-    if (render_tree_ && old_pos_x != area_.pos_x) {
-      render_tree_->CheckHover();
-      render_tree_->is_render_required_ = true;
+    if (render_tree_ && old_area.pos_x != area_.pos_x) {
+      render_tree_->ProcessGeometryChange(this);
+      render_tree_->AddDamage(old_area);
+      render_tree_->AddDamage(area_);
     }
   } else {
     area_.pos_x = pos_x;
@@ -302,24 +1230,95 @@ void TreeBlock::SetPosX(SizeType pos_x) noexcept {
 
 void TreeBlock::SetPosY(SizeType pos_y) noexcept {
   if (parent_) {
-    auto old_pos_y = area_.pos_y;
+    auto old_area{area_};
 
     CheckAndSetPosY(pos_y);
 
-    if (render_tree_ && old_pos_y != area_.pos_y) {
-      render_tree_->CheckHover();
-      render_tree_->is_render_required_ = true;
+    if (render_tree_ && old_area.pos_y != area_.pos_y) {
+      render_tree_->ProcessGeometryChange(this);
+      render_tree_->AddDamage(old_area);
+      render_tree_->AddDamage(area_);
     }
   } else {
     area_.pos_y = pos_y;
   }
 }
 
+void TreeBlock::EnableOpaqueness() noexcept {
+  if (!is_opaque_) {
+    is_opaque_ = true;
+    if (render_tree_) {
+      render_tree_->opaque_flags_[id_] = true;
+      render_tree_->AddDamage(area_);
+    }
+  }
+}
+
+void TreeBlock::DisableOpaqueness() noexcept {
+  if (is_opaque_) {
+    is_opaque_ = false;
+    if (render_tree_) {
+      render_tree_->opaque_flags_[id_] = false;
+      render_tree_->AddDamage(area_);
+    }
+  }
+}
+
+void TreeBlock::SetEventMask(EventMask mask) noexcept {
+  event_mask_ = mask;
+  if (render_tree_) {
+    render_tree_->event_masks_[id_] = GetEffectiveEventMask();
+    render_tree_->are_movement_listeners_valid_ = false;
+  }
+}
+
+void TreeBlock::StopPropagation() noexcept {
+  if (render_tree_) {
+    render_tree_->is_propagation_stopped_ = true;
+  }
+}
+
 void TreeBlock::RenderIsRequired() noexcept {
   assert(render_tree_ &&
          "Error in an invocation of the RenderIsRequired method. There is no "
          "RenderTree object binded to a block");
-  render_tree_->is_render_required_ = true;
+  InvalidateLayer();
+  render_tree_->AddDamage(area_);
+}
+
+[[nodiscard]] bool TreeBlock::Render(
+    const Area &viewport, const BlockRenderState &state) const noexcept {
+  if (handler_ != nullptr) {
+    auto &gl_state{*state.gl_state};
+    gl_state.Viewport(viewport.pos_x, viewport.pos_y, viewport.width,
+                      viewport.height);
+    gl_state.ClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    auto result{handler_->Render(state)};
+    if (!handler_->UsesGLStateCache()) {
+      // the handler might have changed the state bypassing the cache
+      gl_state.Invalidate();
+    }
+
+    return result;
+  }
+
+  return false;
+}
+
+[[nodiscard]] GLStateCache &TreeBlock::GetGLStateCache() const noexcept {
+  assert(render_tree_ &&
+         "Error in an invocation of the GetGLStateCache method. There is no "
+         "RenderTree object binded to a block");
+  return render_tree_->gl_state_;
+}
+
+[[nodiscard]] StreamingBuffer &TreeBlock::GetStreamingBuffer() const noexcept {
+  assert(render_tree_ &&
+         "Error in an invocation of the GetStreamingBuffer method. There is no "
+         "RenderTree object binded to a block");
+  return render_tree_->stream_buffer_;
 }
 
 [[nodiscard]] const MouseInfo &TreeBlock::GetMouseInfo() const noexcept {
@@ -336,7 +1335,8 @@ void TreeBlock::ProcessHover() noexcept {
     handler_->ProcessHover(*this);
 
     if (is_hover_activated_) {
-      render_tree_->is_render_required_ = true;
+      InvalidateLayer();
+      render_tree_->AddDamage(area_);
     }
   }
 }
@@ -17,6 +17,8 @@ struct MouseInfo {
   PtrDiff scroll_offset_y;
 
   MouseButtonEvent last_mouse_button_event_;
+
+  EventPhase event_phase;  // of the button or scroll event being routed
 };
 
 struct TreeInfo {
@@ -1,5 +1,8 @@
 #include "ShaderProgram.hpp"
 
+ShaderProgram::ShaderProgram()
+    : vertex_shader{}, fragment_shader{}, shader_program{} {}
+
 ShaderProgram::ShaderProgram(const char *vertex_shader_path,
                              const char *fragment_shader_path) {
   CompileAndLinkShaders(vertex_shader_path, fragment_shader_path);
@@ -14,6 +17,16 @@ bool ShaderProgram::CompileAndLinkShaders(const char *vertex_shader_path,
   return true;
 }
 
+bool ShaderProgram::CompileAndLinkShaderSources(
+    const char *vertex_shader_code, const char *fragment_shader_code) {
+  if (!CompileShaderSource(vertex_shader_code, GL_VERTEX_SHADER)) return false;
+  if (!CompileShaderSource(fragment_shader_code, GL_FRAGMENT_SHADER))
+    return false;
+  if (!LinkShaders()) return false;
+
+  return true;
+}
+
 bool ShaderProgram::CompileShader(const char *shader_path, GLenum shader) {
   std::ifstream shader_file(shader_path);
   if (!shader_file.is_open()) {
@@ -30,10 +43,15 @@ bool ShaderProgram::CompileShader(const char *shader_path, GLenum shader) {
 
   shader_file.read(&shader_code[0], n_char);
   shader_code[n_char] = '\0';
-  const char *shader_code_ptr = shader_code.c_str();
+  shader_file.close();
 
+  return CompileShaderSource(shader_code.c_str(), shader);
+}
+
+bool ShaderProgram::CompileShaderSource(const char *shader_code,
+                                        GLenum shader) {
   unsigned int compiled_shader = glCreateShader(shader);
-  glShaderSource(compiled_shader, 1, &shader_code_ptr, nullptr);
+  glShaderSource(compiled_shader, 1, &shader_code, nullptr);
   glCompileShader(compiled_shader);
 
   int success;
@@ -60,7 +78,6 @@ bool ShaderProgram::CompileShader(const char *shader_path, GLenum shader) {
   else
     fragment_shader = compiled_shader;
 
-  shader_file.close();
   return true;
 }
 
@@ -8,14 +8,21 @@
 
 class ShaderProgram {
 public:
+  ShaderProgram();
+
   ShaderProgram(const char *vertex_shader_path,
                 const char *fragment_shader_path);
 
   bool CompileAndLinkShaders(const char *vertex_shader_path,
                              const char *fragment_shader_path);
 
+  bool CompileAndLinkShaderSources(const char *vertex_shader_code,
+                                   const char *fragment_shader_code);
+
   bool CompileShader(const char *shader_path, GLenum shader);
 
+  bool CompileShaderSource(const char *shader_code, GLenum shader);
+
   bool LinkShaders();
 
   ~ShaderProgram();
@@ -0,0 +1,115 @@
+#include "SpatialGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace graphics {
+
+namespace {
+
+constexpr SizeType kMaxGridSide{64};
+
+}  // namespace
+
+SpatialGrid::SpatialGrid() noexcept
+    : bounds_{}, columns_{}, rows_{}, cell_width_{}, cell_height_{}, cells_{} {}
+
+void SpatialGrid::Reset(const Area &bounds, SizeType item_count) noexcept {
+  bounds_ = bounds;
+
+  // about one item per cell, the cells follow the aspect of the bounds
+  auto aspect{bounds.height ? static_cast<double>(bounds.width) /
+                                  static_cast<double>(bounds.height)
+                            : 1.};
+  auto side{std::sqrt(static_cast<double>(std::max<SizeType>(item_count, 1)))};
+  columns_ = std::clamp<SizeType>(std::lround(side * std::sqrt(aspect)), 1,
+                                  kMaxGridSide);
+  rows_ = std::clamp<SizeType>(std::lround(side / std::sqrt(aspect)), 1,
+                               kMaxGridSide);
+  columns_ = std::min(columns_, std::max<SizeType>(bounds.width, 1));
+  rows_ = std::min(rows_, std::max<SizeType>(bounds.height, 1));
+
+  // the last cells also take the inclusive right and top edges
+  cell_width_ = std::max<SizeType>(bounds.width / columns_, 1);
+  cell_height_ = std::max<SizeType>(bounds.height / rows_, 1);
+
+  cells_.resize(columns_ * rows_);
+  for (auto &cell : cells_) {
+    cell.clear();
+  }
+}
+
+void SpatialGrid::Insert(SizeType item, const Area &area) noexcept {
+  SizeType first_column{}, first_row{}, last_column{}, last_row{};
+  if (!GetCellRange(area, first_column, first_row, last_column, last_row)) {
+    return;
+  }
+
+  for (auto row{first_row}; row <= last_row; ++row) {
+    for (auto column{first_column}; column <= last_column; ++column) {
+      cells_[row * columns_ + column].push_back(item);
+    }
+  }
+}
+
+void SpatialGrid::Remove(SizeType item, const Area &area) noexcept {
+  SizeType first_column{}, first_row{}, last_column{}, last_row{};
+  if (!GetCellRange(area, first_column, first_row, last_column, last_row)) {
+    return;
+  }
+
+  for (auto row{first_row}; row <= last_row; ++row) {
+    for (auto column{first_column}; column <= last_column; ++column) {
+      auto &cell{cells_[row * columns_ + column]};
+      if (auto iter{std::find(cell.begin(), cell.end(), item)};
+          iter != cell.end()) {
+        *iter = cell.back();
+        cell.pop_back();
+      }
+    }
+  }
+}
+
+[[nodiscard]] const Vector<SizeType> *SpatialGrid::Find(
+    PtrDiff x, PtrDiff y) const noexcept {
+  if (cells_.empty() || !bounds_.DoesPointFallWithinArea(x, y)) {
+    return nullptr;
+  }
+
+  auto column{std::min((static_cast<SizeType>(x) - bounds_.pos_x) / cell_width_,
+                       columns_ - 1)};
+  auto row{std::min((static_cast<SizeType>(y) - bounds_.pos_y) / cell_height_,
+                    rows_ - 1)};
+  return &cells_[row * columns_ + column];
+}
+
+[[nodiscard]] bool SpatialGrid::GetCellRange(
+    const Area &area, SizeType &first_column, SizeType &first_row,
+    SizeType &last_column, SizeType &last_row) const noexcept {
+  // both areas include their right and top edges
+  auto bounds_right{bounds_.pos_x + bounds_.width};
+  auto bounds_top{bounds_.pos_y + bounds_.height};
+  auto right{area.pos_x + area.width};
+  auto top{area.pos_y + area.height};
+  if (cells_.empty() || area.pos_x > bounds_right || right < bounds_.pos_x ||
+      area.pos_y > bounds_top || top < bounds_.pos_y) {
+    return false;
+  }
+
+  auto to_column{[this](SizeType x) {
+    return std::min((std::max(x, bounds_.pos_x) - bounds_.pos_x) / cell_width_,
+                    columns_ - 1);
+  }};
+  auto to_row{[this](SizeType y) {
+    return std::min((std::max(y, bounds_.pos_y) - bounds_.pos_y) / cell_height_,
+                    rows_ - 1);
+  }};
+
+  first_column = to_column(area.pos_x);
+  last_column = to_column(right);
+  first_row = to_row(area.pos_y);
+  last_row = to_row(top);
+  return true;
+}
+
+}  // namespace graphics
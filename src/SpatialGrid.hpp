@@ -0,0 +1,69 @@
+#ifndef SPATIALGRID_HPP
+#define SPATIALGRID_HPP
+
+#include "TreeBlockAreas.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+// Class SpatialGrid splits an area into uniform cells, every cell lists the
+// items whose areas overlap it. A point query looks at a single cell, so hit
+// testing does not depend on the number of items. Items are identified by
+// numbers given by the user and are moved incrementally.
+class SpatialGrid {
+ public:
+  SpatialGrid() noexcept;
+
+  // removes all the items and splits the bounds into cells suiting the
+  // expected number of items
+  void Reset(const Area &bounds, SizeType item_count) noexcept;
+
+  void Insert(SizeType item, const Area &area) noexcept;
+
+  // the area has to be the one the item was inserted with
+  void Remove(SizeType item, const Area &area) noexcept;
+
+  // returns the items whose areas may contain the point in no particular
+  // order, nullptr if the point is out of the bounds
+  [[nodiscard]] const Vector<SizeType> *Find(PtrDiff x,
+                                             PtrDiff y) const noexcept;
+
+  // calls the predicate with the items whose areas may overlap the area, an
+  // item once per common cell, and returns true as soon as the predicate does
+  template <typename Predicate>
+  [[nodiscard]] bool IsAnyNear(const Area &area,
+                               Predicate predicate) const noexcept {
+    SizeType first_column{}, first_row{}, last_column{}, last_row{};
+    if (!GetCellRange(area, first_column, first_row, last_column, last_row)) {
+      return false;
+    }
+
+    for (auto row{first_row}; row <= last_row; ++row) {
+      for (auto column{first_column}; column <= last_column; ++column) {
+        for (auto item : cells_[row * columns_ + column]) {
+          if (predicate(item)) {
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+ private:
+  // returns false if the area does not overlap the bounds
+  [[nodiscard]] bool GetCellRange(const Area &area, SizeType &first_column,
+                                  SizeType &first_row, SizeType &last_column,
+                                  SizeType &last_row) const noexcept;
+
+  Area bounds_;
+  SizeType columns_;
+  SizeType rows_;
+  SizeType cell_width_;
+  SizeType cell_height_;
+  Vector<Vector<SizeType>> cells_;  // row by row
+};
+
+}  // namespace graphics
+
+#endif  // SPATIALGRID_HPP
@@ -0,0 +1,98 @@
+#include "StreamingBuffer.hpp"
+
+#include <cstdlib>
+
+namespace graphics {
+
+StreamingBuffer::StreamingBuffer(SizeType segment_size,
+                                 SizeType segment_count) noexcept
+    : segment_size_{segment_size},
+      segment_count_{segment_count},
+      buffer_{},
+      mapped_data_{},
+      fences_(segment_count),
+      segment_index_{},
+      segment_offset_{} {
+  constexpr GLbitfield kFlags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                              GL_MAP_COHERENT_BIT};
+  auto buffer_size{static_cast<GLsizeiptr>(segment_size_ * segment_count_)};
+
+  glCreateBuffers(1, &buffer_);
+  glNamedBufferStorage(buffer_, buffer_size, nullptr, kFlags);
+  mapped_data_ = static_cast<unsigned char *>(
+      glMapNamedBufferRange(buffer_, 0, buffer_size, kFlags));
+  if (!mapped_data_) {
+    exit(1);
+  }
+}
+
+StreamingBuffer::~StreamingBuffer() {
+  for (auto fence : fences_) {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+
+  glUnmapNamedBuffer(buffer_);
+  glDeleteBuffers(1, &buffer_);
+}
+
+[[nodiscard]] bool StreamingBuffer::Allocate(SizeType size, SizeType alignment,
+                                             Allocation &result) noexcept {
+  if (size > segment_size_) {
+    return false;
+  }
+
+  auto offset{(segment_offset_ + alignment - 1) / alignment * alignment};
+  if (offset + size > segment_size_) {
+    MoveToNextSegment();
+    offset = 0;
+  }
+
+  auto buffer_offset{segment_index_ * segment_size_ + offset};
+  result = {mapped_data_ + buffer_offset,
+            static_cast<GLintptr>(buffer_offset)};
+
+  segment_offset_ = offset + size;
+  return true;
+}
+
+void StreamingBuffer::EndFrame() noexcept {
+  if (segment_offset_ != 0) {
+    MoveToNextSegment();
+  }
+}
+
+[[nodiscard]] GLuint StreamingBuffer::GetBuffer() const noexcept {
+  return buffer_;
+}
+
+[[nodiscard]] SizeType StreamingBuffer::GetSegmentSize() const noexcept {
+  return segment_size_;
+}
+
+void StreamingBuffer::MoveToNextSegment() noexcept {
+  fences_[segment_index_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  segment_index_ = (segment_index_ + 1) % segment_count_;
+  segment_offset_ = 0;
+
+  // waits until the GPU stops reading the segment
+  if (auto &fence{fences_[segment_index_]}; fence) {
+    constexpr GLuint64 kTimeout{1'000'000};  // 1 ms
+    GLbitfield flags{GL_SYNC_FLUSH_COMMANDS_BIT};
+    while (true) {
+      auto status{glClientWaitSync(fence, flags, kTimeout)};
+      if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED ||
+          status == GL_WAIT_FAILED) {
+        break;
+      }
+      flags = 0;
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+  }
+}
+
+}  // namespace graphics
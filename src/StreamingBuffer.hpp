@@ -0,0 +1,57 @@
+#ifndef STREAMINGBUFFER_HPP
+#define STREAMINGBUFFER_HPP
+
+#include "PDH_GLFW_OpenGL.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+// Class StreamingBuffer is a persistently mapped coherent ring buffer for
+// data written by the CPU once per frame. The ring is split into segments,
+// every segment is fenced when it is left and the fence is waited for before
+// the segment is written again, so no implicit synchronization is required.
+class StreamingBuffer {
+ public:
+  struct Allocation {
+    void *data;       // mapped memory the data should be written into
+    GLintptr offset;  // offset of the data from the beginning of the buffer
+  };
+
+  StreamingBuffer(SizeType segment_size, SizeType segment_count) noexcept;
+
+  ~StreamingBuffer();
+
+  StreamingBuffer(const StreamingBuffer &) = delete;
+
+  StreamingBuffer &operator=(const StreamingBuffer &) = delete;
+
+  // returns false if the size exceeds the size of a segment, moves to the next
+  // segment if there is not enough space left in the current one
+  [[nodiscard]] bool Allocate(SizeType size, SizeType alignment,
+                              Allocation &result) noexcept;
+
+  // fences the data written in the frame, the next frame starts in the next
+  // segment
+  void EndFrame() noexcept;
+
+  [[nodiscard]] GLuint GetBuffer() const noexcept;
+
+  [[nodiscard]] SizeType GetSegmentSize() const noexcept;
+
+ private:
+  void MoveToNextSegment() noexcept;
+
+  const SizeType segment_size_;
+  const SizeType segment_count_;
+
+  GLuint buffer_;
+  unsigned char *mapped_data_;
+  Vector<GLsync> fences_;  // one fence per segment
+
+  SizeType segment_index_;
+  SizeType segment_offset_;  // offset of the free space within the segment
+};
+
+}  // namespace graphics
+
+#endif  // STREAMINGBUFFER_HPP
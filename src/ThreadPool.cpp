@@ -0,0 +1,126 @@
+#include "ThreadPool.hpp"
+
+#include <utility>
+
+namespace graphics {
+
+namespace {
+
+// the pool and the queue of the worker running on the current thread
+thread_local const ThreadPool *current_pool{};
+thread_local SizeType current_queue_index{};
+
+}  // namespace
+
+ThreadPool::ThreadPool(SizeType thread_count) noexcept
+    : queues_{},
+      threads_{},
+      queued_tasks_{},
+      pending_tasks_{},
+      wake_mutex_{},
+      wake_condition_{},
+      is_stopped_{} {
+  for (SizeType i{}; i <= thread_count; ++i) {
+    queues_.push_back(std::make_unique<TaskQueue>());
+  }
+
+  for (SizeType i{}; i < thread_count; ++i) {
+    threads_.emplace_back([this, i]() { WorkerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{wake_mutex_};
+    is_stopped_ = true;
+  }
+  wake_condition_.notify_all();
+
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPool::Submit(Task task) noexcept {
+  // counted before it is queued, so the task can not finish before that
+  ++pending_tasks_;
+
+  auto index{current_pool == this ? current_queue_index : threads_.size()};
+  {
+    auto &queue{*queues_[index]};
+    std::lock_guard lock{queue.mutex};
+    queue.tasks.push_back(std::move(task));
+  }
+
+  {
+    std::lock_guard lock{wake_mutex_};
+    ++queued_tasks_;
+  }
+  wake_condition_.notify_one();
+}
+
+void ThreadPool::Wait() noexcept {
+  auto index{current_pool == this ? current_queue_index : threads_.size()};
+  while (pending_tasks_ != 0) {
+    if (!TryRunTask(index)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+[[nodiscard]] SizeType ThreadPool::GetThreadCount() const noexcept {
+  return threads_.size();
+}
+
+void ThreadPool::WorkerLoop(SizeType index) noexcept {
+  current_pool = this;
+  current_queue_index = index;
+
+  for (;;) {
+    {
+      std::unique_lock lock{wake_mutex_};
+      wake_condition_.wait(
+          lock, [this]() { return queued_tasks_ != 0 || is_stopped_; });
+      if (is_stopped_) {
+        return;
+      }
+    }
+
+    while (TryRunTask(index)) {
+    }
+  }
+}
+
+[[nodiscard]] bool ThreadPool::TryRunTask(SizeType index) noexcept {
+  Task task{};
+
+  // the own queue is used as a stack, other queues are robbed from the front
+  // where the largest pieces of work usually are
+  auto queue_count{queues_.size()};
+  for (SizeType i{}; i < queue_count && !task; ++i) {
+    auto &queue{*queues_[(index + i) % queue_count]};
+    std::lock_guard lock{queue.mutex};
+    if (queue.tasks.empty()) {
+      continue;
+    }
+
+    if (i == 0) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+  }
+
+  if (!task) {
+    return false;
+  }
+
+  --queued_tasks_;
+  task();
+  --pending_tasks_;
+  return true;
+}
+
+}  // namespace graphics
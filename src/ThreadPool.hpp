@@ -0,0 +1,66 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Usings.hpp"
+
+namespace graphics {
+
+// Class ThreadPool runs tasks on a fixed set of worker threads. Every worker
+// has its own queue, tasks submitted by a worker go to its queue and are
+// taken from its back, so nested tasks stay on the thread that produced them
+// while idle workers steal from the front of other queues.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(SizeType thread_count) noexcept;
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // can be called from the tasks
+  void Submit(Task task) noexcept;
+
+  // runs tasks on the calling thread until all the submitted tasks, including
+  // the ones submitted meanwhile, are done
+  void Wait() noexcept;
+
+  [[nodiscard]] SizeType GetThreadCount() const noexcept;
+
+ private:
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void WorkerLoop(SizeType index) noexcept;
+
+  // pops a task from the queue with the index or steals one from the others
+  [[nodiscard]] bool TryRunTask(SizeType index) noexcept;
+
+  // the last queue receives tasks submitted by threads outside the pool
+  Vector<std::unique_ptr<TaskQueue>> queues_;
+  Vector<std::thread> threads_;
+
+  std::atomic<SizeType> queued_tasks_;   // waiting in the queues
+  std::atomic<SizeType> pending_tasks_;  // submitted and not finished yet
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_condition_;
+  bool is_stopped_;
+};
+
+}  // namespace graphics
+
+#endif  // THREADPOOL_HPP
@@ -1,14 +1,34 @@
 #include "TreeBlock.hpp"
 
+#include <algorithm>
+
 namespace graphics {
 
 TreeBlock::TreeBlock(TreeBlockHandlerBase *handler) noexcept
     : area_{},
+      id_{},
+      parent_{},
       children_list_{},
       render_tree_{},
       handler_{handler},
       hover_{},
-      is_hover_activated_{} {}
+      is_hover_activated_{},
+      is_opaque_{},
+      event_mask_{kAllEvents},
+      layout_{},
+      layout_cache_{},
+      width_anchor_{},
+      height_anchor_{},
+      pos_x_anchor_{},
+      pos_y_anchor_{},
+      is_custom_layout_{},
+      flex_item_{0, 0.f, 1.f, 0},
+      is_layout_dirty_{},
+      is_in_layout_queue_{},
+      layer_{},
+      is_layer_enabled_{},
+      is_layer_valid_{},
+      is_layer_has_content_{} {}
 
 void TreeBlock::SetRelativeNormalizedWidth(float width) noexcept {
   if (parent_) {
@@ -42,7 +62,7 @@ void TreeBlock::SetRelativePosX(SizeType pos_x) noexcept {
 
 void TreeBlock::SetRelativePosY(SizeType pos_y) noexcept {
   if (parent_) {
-    SetPosX(parent_->area_.pos_y + pos_y);
+    SetPosY(parent_->area_.pos_y + pos_y);
   }
 }
 
@@ -70,12 +90,80 @@ void TreeBlock::SetRelativeNormalizedPosY(float pos_y) noexcept {
   }
 }
 
+void TreeBlock::AnchorWidth(Anchor anchor) noexcept {
+  width_anchor_ = anchor;
+  ApplyAnchors();
+}
+
+void TreeBlock::AnchorHeight(Anchor anchor) noexcept {
+  height_anchor_ = anchor;
+  ApplyAnchors();
+}
+
+void TreeBlock::AnchorPosX(Anchor anchor) noexcept {
+  pos_x_anchor_ = anchor;
+  ApplyAnchors();
+}
+
+void TreeBlock::AnchorPosY(Anchor anchor) noexcept {
+  pos_y_anchor_ = anchor;
+  ApplyAnchors();
+}
+
+void TreeBlock::ClearAnchors() noexcept {
+  width_anchor_ = {};
+  height_anchor_ = {};
+  pos_x_anchor_ = {};
+  pos_y_anchor_ = {};
+}
+
+void TreeBlock::EnableCustomLayout() noexcept { is_custom_layout_ = true; }
+
+void TreeBlock::DisableCustomLayout() noexcept { is_custom_layout_ = false; }
+
+void TreeBlock::EnableLayoutCache(SizeType capacity) noexcept {
+  layout_cache_ = std::make_unique<LayoutCache>(capacity);
+}
+
+void TreeBlock::DisableLayoutCache() noexcept { layout_cache_.reset(); }
+
+void TreeBlock::InvalidateLayoutCache() noexcept {
+  if (layout_cache_) {
+    layout_cache_->Clear();
+  }
+}
+
 void TreeBlock::EnableHoverRerender() noexcept { is_hover_activated_ = true; }
 
 void TreeBlock::DisableHoverRerender() noexcept { is_hover_activated_ = false; }
 
+void TreeBlock::EnableRetainedLayer() noexcept {
+  if (!is_layer_enabled_) {
+    is_layer_enabled_ = true;
+    is_layer_valid_ = false;
+  }
+}
+
+void TreeBlock::DisableRetainedLayer() noexcept {
+  // the layer is released the next time the block is rendered
+  is_layer_enabled_ = false;
+  is_layer_valid_ = false;
+}
+
+void TreeBlock::InvalidateLayer() noexcept { is_layer_valid_ = false; }
+
 [[nodiscard]] bool TreeBlock::IsHovered() const noexcept { return hover_; }
 
+[[nodiscard]] bool TreeBlock::IsOpaque() const noexcept { return is_opaque_; }
+
+[[nodiscard]] EventMask TreeBlock::GetEventMask() const noexcept {
+  return event_mask_;
+}
+
+[[nodiscard]] EventMask TreeBlock::GetEffectiveEventMask() const noexcept {
+  return handler_ ? event_mask_ & handler_->GetEventMask() : kNoEvents;
+}
+
 [[nodiscard]] const Area &TreeBlock::GetArea() const noexcept { return area_; }
 
 [[nodiscard]] NormalizedArea TreeBlock::GetRelaftiveNormalizedArea()
@@ -97,16 +185,12 @@ void TreeBlock::DisableHoverRerender() noexcept { is_hover_activated_ = false; }
   return children_list_;
 }
 
-[[nodiscard]] bool TreeBlock::Render() const noexcept {
-  if (handler_ != nullptr) {
-    glViewport(area_.pos_x, area_.pos_y, area_.width, area_.height);
-    glClearColor(0.f, 0.f, 0.f, 0.f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
-
-    return handler_->Render(*this);
-  }
+[[nodiscard]] LayoutBase *TreeBlock::GetLayout() const noexcept {
+  return layout_;
+}
 
-  return false;
+[[nodiscard]] const FlexItem &TreeBlock::GetFlexItem() const noexcept {
+  return flex_item_;
 }
 
 [[nodiscard]] bool TreeBlock::ProcessChangedArea() noexcept {
@@ -125,6 +209,69 @@ void TreeBlock::DisableHoverRerender() noexcept { is_hover_activated_ = false; }
   return false;
 }
 
+[[nodiscard]] bool TreeBlock::HasAnchors() const noexcept {
+  return width_anchor_.type != AnchorType::kNone ||
+         height_anchor_.type != AnchorType::kNone ||
+         pos_x_anchor_.type != AnchorType::kNone ||
+         pos_y_anchor_.type != AnchorType::kNone;
+}
+
+[[nodiscard]] Area TreeBlock::ResolveAnchors() const noexcept {
+  const auto &parent_area{parent_->area_};
+
+  auto resolve_size{[](const Anchor &anchor, SizeType size,
+                       SizeType parent_size) {
+    switch (anchor.type) {
+      case AnchorType::kPixels:
+        size = static_cast<SizeType>(std::max(anchor.value, 0.f));
+        break;
+      case AnchorType::kNormalized:
+        size = parent_size * std::clamp(anchor.value, 0.f, 1.f);
+        break;
+      default:
+        break;
+    }
+
+    return std::min(size, parent_size);
+  }};
+
+  // positions are kept within the parent like CheckAndSetPosX does
+  auto resolve_pos{[](const Anchor &anchor, SizeType pos, SizeType size,
+                      SizeType parent_pos, SizeType parent_size) {
+    switch (anchor.type) {
+      case AnchorType::kPixels:
+        pos = parent_pos + static_cast<SizeType>(std::max(anchor.value, 0.f));
+        break;
+      case AnchorType::kNormalized:
+        pos = parent_pos + parent_size * std::clamp(anchor.value, 0.f, 1.f);
+        break;
+      default:
+        break;
+    }
+
+    return std::clamp(pos, parent_pos, parent_pos + parent_size - size);
+  }};
+
+  Area area{};
+  area.width = resolve_size(width_anchor_, area_.width, parent_area.width);
+  area.height = resolve_size(height_anchor_, area_.height, parent_area.height);
+  area.pos_x = resolve_pos(pos_x_anchor_, area_.pos_x, area.width,
+                           parent_area.pos_x, parent_area.width);
+  area.pos_y = resolve_pos(pos_y_anchor_, area_.pos_y, area.height,
+                           parent_area.pos_y, parent_area.height);
+  return area;
+}
+
+void TreeBlock::ApplyAnchors() noexcept {
+  if (parent_) {
+    auto area{ResolveAnchors()};
+    SetWidth(area.width);
+    SetHeight(area.height);
+    SetPosX(area.pos_x);
+    SetPosY(area.pos_y);
+  }
+}
+
 void TreeBlock::ProcessMouseMovement() noexcept {
   if (handler_) {
     handler_->ProcessMouseMovement(*this);
@@ -2,17 +2,35 @@
 #define TREEBLOCK_HPP
 
 #include <cassert>
+#include <memory>
 
 #include "EventInfo.hpp"
+#include "FlexLayout.hpp"
+#include "GLStateCache.hpp"
+#include "LayoutBase.hpp"
+#include "LayoutCache.hpp"
 #include "RenderTreeInfo.hpp"
+#include "StreamingBuffer.hpp"
 #include "TreeBlockAreas.hpp"
 #include "TreeBlockHandler.hpp"
+#include "TreeBlockLayer.hpp"
 #include "Usings.hpp"
 
 namespace graphics {
 
 class RenderTree;
 
+enum class AnchorType : unsigned char {
+  kNone,        // the value is left to the handler
+  kPixels,      // a size in pixels or an offset from the parent's position
+  kNormalized   // a fraction of the parent's size
+};
+
+struct Anchor {
+  AnchorType type;
+  float value;
+};
+
 class TreeBlock {
  public:
   TreeBlock(TreeBlockHandlerBase *handler) noexcept;
@@ -37,6 +55,47 @@ class TreeBlock {
 
   void SetRelativeNormalizedPosY(float pos_y) noexcept;
 
+  // unlike the setters above, anchors are kept by the block and resolved
+  // against the area of the parent every time it changes. A block with
+  // anchors is placed without calling its handler, unless the custom layout
+  // is enabled, then the handler is called after the anchors are resolved
+  void AnchorWidth(Anchor anchor) noexcept;
+
+  void AnchorHeight(Anchor anchor) noexcept;
+
+  void AnchorPosX(Anchor anchor) noexcept;
+
+  void AnchorPosY(Anchor anchor) noexcept;
+
+  void ClearAnchors() noexcept;
+
+  void EnableCustomLayout() noexcept;
+
+  void DisableCustomLayout() noexcept;
+
+  // the layout places the children of the block instead of their handlers,
+  // it is not owned by the block, nullptr removes the layout
+  void SetLayout(LayoutBase *layout) noexcept;
+
+  // describes how the block is placed by the layout of its parent
+  void SetFlexItem(const FlexItem &item) noexcept;
+
+  // lays the children out again, needed after the parameters of the layout
+  // have been changed
+  void RequestChildrenLayout() noexcept;
+
+  // the areas of the children are remembered for the last capacity areas of
+  // the block and reused without calling the handlers of the children. It
+  // suits children whose handlers derive nothing but the areas from the area
+  // of their parent
+  void EnableLayoutCache(SizeType capacity) noexcept;
+
+  void DisableLayoutCache() noexcept;
+
+  // has to be called when the children would be placed differently for the
+  // same area of the block, RequestChildrenLayout() invalidates the cache too
+  void InvalidateLayoutCache() noexcept;
+
   void EnableHoverRerender() noexcept;
 
   void DisableHoverRerender() noexcept;
@@ -47,23 +106,76 @@ class TreeBlock {
 
   void RenderIsRequired() noexcept;
 
+  // the block receives the events present both in the mask and in the mask
+  // of its handler, all the events by default
+  void SetEventMask(EventMask mask) noexcept;
+
+  // called by a handler processing a button or scroll event, the blocks
+  // further along the route do not receive the event
+  void StopPropagation() noexcept;
+
+  // an opaque block promises to cover its whole area with fully opaque
+  // pixels, so earlier siblings hidden behind it are neither rendered nor
+  // composited
+  void EnableOpaqueness() noexcept;
+
+  void DisableOpaqueness() noexcept;
+
+  // in the retained mode the block is rendered into its own layer once and
+  // the layer is composited until the block content is invalidated
+  void EnableRetainedLayer() noexcept;
+
+  void DisableRetainedLayer() noexcept;
+
+  // marks the layer content as outdated, RenderIsRequired() and a hover
+  // rerender invalidate the layer as well
+  void InvalidateLayer() noexcept;
+
   [[nodiscard]] bool IsHovered() const noexcept;
 
+  [[nodiscard]] bool IsOpaque() const noexcept;
+
   [[nodiscard]] bool IsCursorOutOfWindow() const noexcept;
 
   [[nodiscard]] const Area &GetArea() const noexcept;
 
   [[nodiscard]] const MouseInfo &GetMouseInfo() const noexcept;
 
+  // handlers change the OpenGL state through the cache of the tree, see
+  // TreeBlockHandlerBase::UsesGLStateCache
+  [[nodiscard]] GLStateCache &GetGLStateCache() const noexcept;
+
+  // handlers write their per-frame vertex data into the ring buffer of the
+  // tree instead of updating their own buffers with glBufferSubData
+  [[nodiscard]] StreamingBuffer &GetStreamingBuffer() const noexcept;
+
   [[nodiscard]] NormalizedArea GetRelaftiveNormalizedArea() const noexcept;
 
   [[nodiscard]] const List<TreeBlock *> &GetChildrenList() const noexcept;
 
+  [[nodiscard]] LayoutBase *GetLayout() const noexcept;
+
+  [[nodiscard]] const FlexItem &GetFlexItem() const noexcept;
+
+  [[nodiscard]] EventMask GetEventMask() const noexcept;
+
  private:
-  [[nodiscard]] bool Render() const noexcept;
+  // renders the block into the viewport of the currently bound framebuffer
+  [[nodiscard]] bool Render(const Area &viewport,
+                            const BlockRenderState &state) const noexcept;
 
   [[nodiscard]] bool ProcessChangedArea() noexcept;
 
+  [[nodiscard]] bool HasAnchors() const noexcept;
+
+  // combines the mask of the block with the mask of its handler
+  [[nodiscard]] EventMask GetEffectiveEventMask() const noexcept;
+
+  // returns the area the anchors give within the current area of the parent
+  [[nodiscard]] Area ResolveAnchors() const noexcept;
+
+  void ApplyAnchors() noexcept;
+
   void ProcessHover() noexcept;
 
   void ProcessMouseMovement() noexcept;
@@ -72,6 +184,10 @@ class TreeBlock {
 
   void ProcessMouseScroll() noexcept;
 
+  // sets the area computed by the layout of the parent, returns true if the
+  // area has changed
+  [[nodiscard]] bool SetLayoutArea(const Area &area) noexcept;
+
   void CheckAndSetPosX(SizeType pos_x) noexcept;
 
   void CheckAndSetPosY(SizeType pos_y) noexcept;
@@ -79,6 +195,7 @@ class TreeBlock {
   friend class RenderTree;
 
   Area area_;  // contains block's position and size
+  SizeType id_;  // index of the block in the storage of the tree
   TreeBlock *parent_;
   List<TreeBlock *> children_list_;
   RenderTree *render_tree_;
@@ -86,8 +203,29 @@ class TreeBlock {
 
   bool hover_;  // if equals false, then a cursor is out of this block,
                 // otherwise a cursor is within
-  bool is_hover_activated_;  // defines if is_render_required_ flag should be
-                             // set when hover_ changes its own state
+  bool is_hover_activated_;  // defines if the block's area should be repainted
+                             // when hover_ changes its own state
+
+  bool is_opaque_;
+  EventMask event_mask_;
+
+  LayoutBase *layout_;
+  std::unique_ptr<LayoutCache> layout_cache_;
+
+  Anchor width_anchor_;
+  Anchor height_anchor_;
+  Anchor pos_x_anchor_;
+  Anchor pos_y_anchor_;
+  bool is_custom_layout_;  // the handler is called even if there are anchors
+  FlexItem flex_item_;
+
+  bool is_layout_dirty_;  // the children have to be laid out again
+  bool is_in_layout_queue_;
+
+  TreeBlockLayer layer_;  // used only by the thread rendering frames
+  bool is_layer_enabled_;
+  bool is_layer_valid_;        // the layer keeps up-to-date content
+  bool is_layer_has_content_;  // the handler rendered something into the layer
 };
 
 }  // namespace graphics
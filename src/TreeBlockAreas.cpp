@@ -1,5 +1,7 @@
 #include "TreeBlockAreas.hpp"
 
+#include <algorithm>
+
 namespace graphics {
 
 [[nodiscard]] bool Area::operator==(const Area &other) const noexcept {
@@ -39,4 +41,56 @@ namespace graphics {
   return false;
 }
 
+[[nodiscard]] bool Area::IsEmpty() const noexcept {
+  return width == 0 || height == 0;
+}
+
+[[nodiscard]] bool Area::DoesIntersectArea(const Area &other) const noexcept {
+  if (IsEmpty() || other.IsEmpty()) {
+    return false;
+  }
+
+  if (pos_x >= other.pos_x + other.width || other.pos_x >= pos_x + width) {
+    return false;
+  }
+  if (pos_y >= other.pos_y + other.height || other.pos_y >= pos_y + height) {
+    return false;
+  }
+
+  return true;
+}
+
+[[nodiscard]] bool Area::DoesContainArea(const Area &other) const noexcept {
+  return other.pos_x >= pos_x && other.pos_y >= pos_y &&
+         other.pos_x + other.width <= pos_x + width &&
+         other.pos_y + other.height <= pos_y + height;
+}
+
+[[nodiscard]] Area Area::GetUnion(const Area &other) const noexcept {
+  if (IsEmpty()) {
+    return other;
+  }
+  if (other.IsEmpty()) {
+    return *this;
+  }
+
+  auto min_pos_x{std::min(pos_x, other.pos_x)};
+  auto min_pos_y{std::min(pos_y, other.pos_y)};
+  auto max_pos_x{std::max(pos_x + width, other.pos_x + other.width)};
+  auto max_pos_y{std::max(pos_y + height, other.pos_y + other.height)};
+  return {min_pos_x, min_pos_y, max_pos_x - min_pos_x, max_pos_y - min_pos_y};
+}
+
+[[nodiscard]] Area Area::GetIntersection(const Area &other) const noexcept {
+  if (!DoesIntersectArea(other)) {
+    return {};
+  }
+
+  auto min_pos_x{std::max(pos_x, other.pos_x)};
+  auto min_pos_y{std::max(pos_y, other.pos_y)};
+  auto max_pos_x{std::min(pos_x + width, other.pos_x + other.width)};
+  auto max_pos_y{std::min(pos_y + height, other.pos_y + other.height)};
+  return {min_pos_x, min_pos_y, max_pos_x - min_pos_x, max_pos_y - min_pos_y};
+}
+
 }  // namespace graphics
@@ -17,6 +17,18 @@ struct Area {
 
   [[nodiscard]] bool DoesPointFallWithinArea(PtrDiff x,
                                              PtrDiff y) const noexcept;
+
+  [[nodiscard]] bool IsEmpty() const noexcept;
+
+  [[nodiscard]] bool DoesIntersectArea(const Area &other) const noexcept;
+
+  [[nodiscard]] bool DoesContainArea(const Area &other) const noexcept;
+
+  // returns the smallest area containing both areas
+  [[nodiscard]] Area GetUnion(const Area &other) const noexcept;
+
+  // returns an empty area if the areas do not intersect
+  [[nodiscard]] Area GetIntersection(const Area &other) const noexcept;
 };
 
 struct NormalizedArea {
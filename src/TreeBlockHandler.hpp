@@ -1,6 +1,7 @@
 #ifndef TREEBLOCKHANDELER_HPP
 #define TREEBLOCKHANDELER_HPP
 
+#include "BlockRenderState.hpp"
 #include "EventInfo.hpp"
 #include "Usings.hpp"
 
@@ -13,7 +14,26 @@ class TreeBlockHandlerBase {
   TreeBlockHandlerBase() {}
 
  public:
-  virtual bool Render(const TreeBlock &block) { return false; }
+  // the block itself is not passed, it can be changed by the event thread
+  // while the frame is rendered, see Window::EnableRenderThread
+  virtual bool Render(const BlockRenderState &state) { return false; }
+
+  // a handler returning true promises to change the tracked OpenGL state only
+  // through BlockRenderState::gl_state, otherwise the cache is invalidated
+  // after every call of Render. Per-frame data goes to
+  // BlockRenderState::stream_buffer
+  virtual bool UsesGLStateCache() const { return false; }
+
+  // a handler returning true promises that ProcessChangedArea changes only
+  // the block it is called for and its children, so subtrees consisting of
+  // such handlers can be laid out in parallel, see
+  // RenderTree::EnableParallelLayout
+  virtual bool IsLayoutThreadSafe() const { return false; }
+
+  // the mouse events are dispatched only to the blocks whose handlers are
+  // interested in them, the mask is read when the block is inserted into a
+  // tree
+  virtual EventMask GetEventMask() const { return kAllEvents; }
 
   virtual void ProcessChangedArea(TreeBlock &block) {}
 
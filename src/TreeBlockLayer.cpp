@@ -0,0 +1,72 @@
+#include "TreeBlockLayer.hpp"
+
+#include <cstdlib>
+
+namespace graphics {
+
+TreeBlockLayer::TreeBlockLayer() noexcept
+    : fbo_{}, texture_{}, width_{}, height_{} {}
+
+TreeBlockLayer::~TreeBlockLayer() { Release(); }
+
+void TreeBlockLayer::Resize(SizeType width, SizeType height) noexcept {
+  if (IsAllocated() && width_ == width && height_ == height) {
+    return;
+  }
+
+  Release();
+  if (width == 0 || height == 0) {
+    return;
+  }
+
+  width_ = width;
+  height_ = height;
+
+  // texture storage is immutable, so a new texture is created for every size
+  glCreateTextures(GL_TEXTURE_2D, 1, &texture_);
+  glTextureStorage2D(texture_, 1, GL_RGBA8, width_, height_);
+  glTextureParameteri(texture_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTextureParameteri(texture_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  glCreateFramebuffers(1, &fbo_);
+  glNamedFramebufferTexture(fbo_, GL_COLOR_ATTACHMENT0, texture_, 0);
+
+  if (glCheckNamedFramebufferStatus(fbo_, GL_FRAMEBUFFER) !=
+      GL_FRAMEBUFFER_COMPLETE) {
+    exit(1);
+  }
+}
+
+void TreeBlockLayer::Release() noexcept {
+  if (IsAllocated()) {
+    glDeleteFramebuffers(1, &fbo_);
+    glDeleteTextures(1, &texture_);
+  }
+
+  fbo_ = 0;
+  texture_ = 0;
+  width_ = 0;
+  height_ = 0;
+}
+
+[[nodiscard]] bool TreeBlockLayer::IsAllocated() const noexcept {
+  return fbo_ != 0;
+}
+
+[[nodiscard]] GLuint TreeBlockLayer::GetFramebuffer() const noexcept {
+  return fbo_;
+}
+
+[[nodiscard]] GLuint TreeBlockLayer::GetTexture() const noexcept {
+  return texture_;
+}
+
+[[nodiscard]] SizeType TreeBlockLayer::GetWidth() const noexcept {
+  return width_;
+}
+
+[[nodiscard]] SizeType TreeBlockLayer::GetHeight() const noexcept {
+  return height_;
+}
+
+}  // namespace graphics
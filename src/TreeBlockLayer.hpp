@@ -0,0 +1,46 @@
+#ifndef TREEBLOCKLAYER_HPP
+#define TREEBLOCKLAYER_HPP
+
+#include "PDH_GLFW_OpenGL.hpp"
+#include "Usings.hpp"
+
+namespace graphics {
+
+// Class TreeBlockLayer owns an offscreen texture that keeps the last rendered
+// content of a block, so the block can be composited again without calling
+// its handler.
+class TreeBlockLayer {
+ public:
+  TreeBlockLayer() noexcept;
+
+  ~TreeBlockLayer();
+
+  TreeBlockLayer(const TreeBlockLayer &) = delete;
+
+  TreeBlockLayer &operator=(const TreeBlockLayer &) = delete;
+
+  // (re)allocates the texture if its size differs from the requested one
+  void Resize(SizeType width, SizeType height) noexcept;
+
+  void Release() noexcept;
+
+  [[nodiscard]] bool IsAllocated() const noexcept;
+
+  [[nodiscard]] GLuint GetFramebuffer() const noexcept;
+
+  [[nodiscard]] GLuint GetTexture() const noexcept;
+
+  [[nodiscard]] SizeType GetWidth() const noexcept;
+
+  [[nodiscard]] SizeType GetHeight() const noexcept;
+
+ private:
+  GLuint fbo_;
+  GLuint texture_;
+  SizeType width_;
+  SizeType height_;
+};
+
+}  // namespace graphics
+
+#endif  // TREEBLOCKLAYER_HPP
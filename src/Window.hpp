@@ -2,8 +2,12 @@
 #define WINDOW_HPP
 
 #include <chrono>
+#include <functional>
 #include <iostream>
+#include <thread>
 
+#include "FrameQueue.hpp"
+#include "InputQueue.hpp"
 #include "RenderTree.hpp"
 #include "TreeBlock.hpp"
 #include "Usings.hpp"
@@ -12,6 +16,11 @@ namespace graphics {
 
 using namespace std::literals::chrono_literals;
 
+enum class FrameMode : unsigned char {
+  kOnDemand,   // a frame is rendered only when the tree requires it
+  kContinuous  // the whole tree is repainted every frame, e.g. for animations
+};
+
 class Window {
  public:
   static void InitTools() {
@@ -33,7 +42,22 @@ class Window {
 
   Window(SizeType width, SizeType height, SizeType max_width,
          SizeType max_height, const char *title) noexcept
-      : window_ptr_{}, render_tree_{} {
+      : window_ptr_{},
+        render_tree_{},
+        frame_mode_{FrameMode::kOnDemand},
+        time_between_frames_{kDefaultTimeBetweenFrames},
+        is_render_thread_enabled_{},
+        render_thread_{},
+        frame_queue_{},
+        frame_{},
+        swap_interval_{},
+        is_swap_interval_set_{},
+        is_resize_pending_{},
+        is_resize_preview_enabled_{},
+        pending_width_{},
+        pending_height_{},
+        last_resize_time_{},
+        input_queue_{} {
     windows_vec_.push_back(this);
 
     window_ptr_ = glfwCreateWindow(width, height, title, NULL, NULL);
@@ -48,6 +72,8 @@ class Window {
 
     render_tree_ =
         new RenderTree{{0, 0, width, height}, max_width, max_height, nullptr};
+    // wakes the loop up if the tree is invalidated outside of event processing
+    render_tree_->SetRenderRequestCallback([]() { glfwPostEmptyEvent(); });
 
     glfwSetWindowCloseCallback(window_ptr_, WindowCloseCallback);
     glfwSetCursorPosCallback(window_ptr_, CursorPosCallback);
@@ -71,21 +97,127 @@ class Window {
     glfwDestroyWindow(window_ptr_);
   }
 
+  // the loop sleeps in glfwWaitEvents while nothing has to be rendered and
+  // never renders more often than the target frame rate allows
   void StartLoop() {
+    if (is_render_thread_enabled_) {
+      StartRenderThread();
+    }
+
+    auto next_frame_time{Clock::now()};
+    auto next_input_time{next_frame_time};
+
     while (!glfwWindowShouldClose(window_ptr_)) {
-      auto beg_time{std::chrono::high_resolution_clock::now()};
-      if (render_tree_->Render()) {
-        glfwSwapBuffers(window_ptr_);
+      // the input is dispatched at most once per frame interval. While a
+      // resize is pending it waits for the frame slot applying the new size
+      if (!is_resize_pending_ && !input_queue_.IsEmpty()) {
+        auto cur_time{Clock::now()};
+        if (cur_time < next_input_time) {
+          std::chrono::duration<double> timeout{next_input_time - cur_time};
+          glfwWaitEventsTimeout(timeout.count());
+          continue;
+        }
+
+        input_queue_.Dispatch(*render_tree_);
+        next_input_time = cur_time + time_between_frames_;
+      }
+
+      auto is_frame_required{frame_mode_ == FrameMode::kContinuous ||
+                             is_resize_pending_ ||
+                             render_tree_->IsRenderRequired()};
+
+      if (!is_frame_required) {
+        glfwWaitEvents();
+        continue;
+      }
+
+      auto cur_time{Clock::now()};
+      if (cur_time < next_frame_time) {
+        std::chrono::duration<double> timeout{next_frame_time - cur_time};
+        glfwWaitEventsTimeout(timeout.count());
+        continue;
+      }
+
+      // the size is applied only in a frame slot, the input queued meanwhile
+      // follows it so that the cursor is flipped against the new height
+      if (is_resize_pending_) {
+        if (ProcessPendingResize()) {
+          continue;
+        }
+        if (!input_queue_.IsEmpty()) {
+          input_queue_.Dispatch(*render_tree_);
+          next_input_time = cur_time + time_between_frames_;
+        }
       }
 
-      while (std::chrono::duration_cast<std::chrono::milliseconds>(
-                 std::chrono::high_resolution_clock::now() - beg_time) <
-             kTimeBetweenFrames) {
-        glfwPollEvents();
+      // the render thread wakes the loop up when it takes the previous frame
+      if (is_render_thread_enabled_ && !frame_queue_.IsEmpty()) {
+        glfwWaitEvents();
+        continue;
       }
+
+      if (frame_mode_ == FrameMode::kContinuous) {
+        render_tree_->InvalidateAll();
+      }
+      if (is_render_thread_enabled_) {
+        if (render_tree_->BuildFrame(frame_)) {
+          frame_queue_.Push(frame_);
+        }
+      } else if (render_tree_->Render()) {
+        glfwSwapBuffers(window_ptr_);
+      }
+
+      next_frame_time = cur_time + time_between_frames_;
+      glfwPollEvents();
+    }
+
+    if (is_render_thread_enabled_) {
+      StopRenderThread();
+    }
+  }
+
+  // moves OpenGL submission to a separate thread owning the context, while
+  // the loop keeps processing input and layout. Handlers' Render methods are
+  // called on that thread with the state of their blocks captured when the
+  // frame was built, they must not touch the tree and must synchronize
+  // access to their own data. It must be called before StartLoop
+  void EnableRenderThread() noexcept { is_render_thread_enabled_ = true; }
+
+  void DisableRenderThread() noexcept { is_render_thread_enabled_ = false; }
+
+  void SetFrameMode(FrameMode frame_mode) noexcept { frame_mode_ = frame_mode; }
+
+  // 0 removes the limit, e.g. when frames are paced by vsync
+  void SetTargetFrameRate(SizeType frames_per_second) noexcept {
+    if (frames_per_second == 0) {
+      time_between_frames_ = Clock::duration::zero();
+    } else {
+      time_between_frames_ =
+          std::chrono::duration_cast<Clock::duration>(1s) / frames_per_second;
+    }
+  }
+
+  // while the window is being resized the last frame is stretched to the new
+  // size and the tree is laid out once the size stops changing. It is
+  // ignored if the render thread is enabled, the thread owns the context
+  void EnableResizePreview() noexcept { is_resize_preview_enabled_ = true; }
+
+  void DisableResizePreview() noexcept { is_resize_preview_enabled_ = false; }
+
+  // the number of screen updates to wait for before swapping buffers. The
+  // render thread owns the context while it runs, so there the interval is
+  // applied when the thread is started by the next StartLoop
+  void SetSwapInterval(int interval) noexcept {
+    swap_interval_ = interval;
+    is_swap_interval_set_ = true;
+    if (!render_thread_.joinable()) {
+      glfwSwapInterval(interval);
     }
   }
 
+  // makes the loop process a frame, can be called from any thread
+  static void Wake() noexcept { glfwPostEmptyEvent(); }
+
   void InsertAtRoot(TreeBlock *tree_block) {
     render_tree_->InsertAtRoot(tree_block);
   }
@@ -95,11 +227,10 @@ class Window {
     glfwSetWindowShouldClose(window, GLFW_TRUE);
   }
 
+  // the input callbacks only queue the events, see InputQueue
   static void CursorPosCallback(GLFWwindow *window, double pos_x,
                                 double pos_y) {
-    auto render_tree_ptr{GetWindowObject(window)->render_tree_};
-    auto right_pos_y{render_tree_ptr->GetRootArea().height - pos_y};
-    render_tree_ptr->ProcessMouseMovement(pos_x, right_pos_y);
+    GetWindowObject(window)->input_queue_.PushMouseMovement(pos_x, pos_y);
   }
 
   static void MouseButtonCallback(GLFWwindow *window, int button, int action,
@@ -108,25 +239,80 @@ class Window {
     if (button_event.button != MouseButton::kUnknown &&
         button_event.mod != KeyModifier::kUnknown &&
         button_event.action != Action::kUnknown) {
-      GetWindowObject(window)->render_tree_->ProcessMouseButton(button_event);
+      GetWindowObject(window)->input_queue_.PushMouseButton(button_event);
     }
   }
 
+  // a drag produces many resize events per frame, only the last size is
+  // applied by the loop
   static void WindowSizeCallback(GLFWwindow *window, int width, int height) {
-    GetWindowObject(window)->render_tree_->ChangeArea(
-        {0, 0, static_cast<SizeType>(width), static_cast<SizeType>(height)});
+    auto window_obj{GetWindowObject(window)};
+    window_obj->pending_width_ = static_cast<SizeType>(width);
+    window_obj->pending_height_ = static_cast<SizeType>(height);
+    window_obj->is_resize_pending_ = true;
+    window_obj->last_resize_time_ = Clock::now();
+    Wake();
   }
 
   static void ScrollCallback(GLFWwindow *window, double offset_x,
                              double offset_y) {
-    GetWindowObject(window)->render_tree_->ProcessMouseScroll(offset_x,
-                                                              offset_y);
+    GetWindowObject(window)->input_queue_.PushMouseScroll(offset_x, offset_y);
   }
 
   static void CursorEnterCallback(GLFWwindow *window, int entered) {
     if (!entered) {
-      GetWindowObject(window)->render_tree_->ProcessCursorLeaveWindow();
+      GetWindowObject(window)->input_queue_.PushCursorLeave();
+    }
+  }
+
+  // applies the pending size or presents the preview of it, returns true if
+  // the preview has been presented
+  bool ProcessPendingResize() {
+    Area area{0, 0, pending_width_, pending_height_};
+
+    auto settle_time{last_resize_time_ + kResizeSettleTime};
+    auto cur_time{Clock::now()};
+    if (is_resize_preview_enabled_ && !is_render_thread_enabled_ &&
+        cur_time < settle_time) {
+      render_tree_->PresentStretched(area);
+      glfwSwapBuffers(window_ptr_);
+
+      std::chrono::duration<double> timeout{settle_time - cur_time};
+      glfwWaitEventsTimeout(timeout.count());
+      return true;
+    }
+
+    is_resize_pending_ = false;
+    render_tree_->ChangeArea(area);
+    return false;
+  }
+
+  void StartRenderThread() {
+    frame_queue_.Restart();
+    glfwMakeContextCurrent(nullptr);
+    render_thread_ = std::thread{[this]() { RenderLoop(); }};
+  }
+
+  void StopRenderThread() {
+    frame_queue_.Stop();
+    render_thread_.join();
+    glfwMakeContextCurrent(window_ptr_);
+  }
+
+  void RenderLoop() {
+    glfwMakeContextCurrent(window_ptr_);
+    if (is_swap_interval_set_) {
+      glfwSwapInterval(swap_interval_);
+    }
+
+    FrameDescription frame;
+    while (frame_queue_.Pop(frame)) {
+      Wake();  // the next frame can be built while this one is rendered
+      render_tree_->RenderFrame(frame);
+      glfwSwapBuffers(window_ptr_);
     }
+
+    glfwMakeContextCurrent(nullptr);
   }
 
   static Window *GetWindowObject(GLFWwindow *window_ptr) {
@@ -137,11 +323,32 @@ class Window {
     }
   }
 
+  using Clock = std::chrono::steady_clock;
+
   inline static Vector<Window *> windows_vec_{};
   GLFWwindow *window_ptr_;
   RenderTree *render_tree_;
 
-  constexpr static std::chrono::milliseconds kTimeBetweenFrames{16ms};
+  FrameMode frame_mode_;
+  Clock::duration time_between_frames_;
+
+  bool is_render_thread_enabled_;
+  std::thread render_thread_;
+  FrameQueue frame_queue_;
+  FrameDescription frame_;  // the frame being built by the event thread
+  int swap_interval_;
+  bool is_swap_interval_set_;  // the default of the driver is kept otherwise
+
+  bool is_resize_pending_;
+  bool is_resize_preview_enabled_;
+  SizeType pending_width_;
+  SizeType pending_height_;
+  Clock::time_point last_resize_time_;
+
+  InputQueue input_queue_;  // the input received since the last dispatch
+
+  constexpr static std::chrono::milliseconds kDefaultTimeBetweenFrames{16ms};
+  constexpr static std::chrono::milliseconds kResizeSettleTime{100ms};
 };
 }  // namespace graphics
 